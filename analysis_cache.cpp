@@ -0,0 +1,247 @@
+#include "analysis_cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char cacheMagic[8] = { 'C', 'H', 'E', 'S', 'S', 'A', 'N', 'L' };
+static const uint32_t cacheVersion = 1;
+
+// Padded to a cache line so that every bucket after it is aligned
+struct AnalysisCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;
+    uint64_t bucketCount;
+    uint64_t reserved[5];
+};
+
+static_assert(sizeof(AnalysisCacheHeader) == 64, "The header layout is part of the file format");
+
+static const size_t BUCKET_BYTES = AnalysisCache::BUCKET_SIZE * sizeof(AnalysisEntry);
+
+static uint16_t entryChecksum(const AnalysisEntry &entry) {
+    uint64_t data = entry.move | (static_cast<uint64_t>(static_cast<uint16_t>(entry.score)) << 16) |
+                    (static_cast<uint64_t>(entry.depth) << 32) | (static_cast<uint64_t>(entry.kind) << 40);
+    uint64_t hash = entry.key ^ (data * 0x9E3779B97F4A7C15ULL);
+    hash = (hash ^ (hash >> 31)) * 0xBF58476D1CE4E5B9ULL;
+    return static_cast<uint16_t>((hash ^ (hash >> 29)) >> 48);
+}
+
+// Empty entries are all zeros, and torn ones fail the checksum
+static bool entryValid(const AnalysisEntry &entry) {
+    return entry.kind != AnalysisEmpty && entry.kind <= AnalysisNoMate && entry.checksum == entryChecksum(entry);
+}
+
+/*
+Put an entry into its bucket, over the entry of the same position, an empty one or the shallowest one.
+With replace unset, a full bucket keeps its entries and the new one is dropped instead.
+*/
+static void insertEntry(AnalysisEntry *entries, uint64_t bucketCount, const AnalysisEntry &entry, bool replace) {
+    AnalysisEntry *bucket = entries + (entry.key & (bucketCount - 1)) * AnalysisCache::BUCKET_SIZE;
+    AnalysisEntry *target = nullptr;
+    for (int i = 0; i < AnalysisCache::BUCKET_SIZE; i++) {
+        bool valid = entryValid(bucket[i]);
+        if (valid && bucket[i].key == entry.key) {
+            target = &bucket[i];
+            break;
+        }
+        if (!valid) {
+            if (!target || entryValid(*target))
+                target = &bucket[i];
+        } else if (replace && (!target || (entryValid(*target) && bucket[i].depth < target->depth))) {
+            target = &bucket[i];
+        }
+    }
+    if (target)
+        std::memcpy(target, &entry, sizeof(entry));
+}
+
+static uint64_t bucketsFor(size_t megabytes) {
+    uint64_t buckets = 1;
+    while (buckets * 2 * BUCKET_BYTES <= megabytes * 1024 * 1024)
+        buckets *= 2;
+    return buckets;
+}
+
+// Make a rename durable by syncing the directory holding the file
+static void syncDirectory(const std::string &path) {
+    size_t slash = path.find_last_of('/');
+    std::string directory = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int handle = ::open(directory.c_str(), O_RDONLY);
+    if (handle >= 0) {
+        fsync(handle);
+        ::close(handle);
+    }
+}
+
+/*
+Write a complete cache file holding the given entries under a temporary name, then rename it over the path.
+Readers of the path see either the old file or the new one, never a partial file.
+*/
+static bool writeCacheFile(const std::string &path, uint64_t bucketCount, const std::vector<AnalysisEntry> &contents) {
+    std::string temporaryPath = path + ".tmp";
+    int handle = ::open(temporaryPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (handle < 0) {
+        std::cerr << "Could not create analysis cache " << temporaryPath << std::endl;
+        return false;
+    }
+
+    size_t size = sizeof(AnalysisCacheHeader) + bucketCount * BUCKET_BYTES;
+    void *image = MAP_FAILED;
+    if (ftruncate(handle, size) == 0)
+        image = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+    if (image == MAP_FAILED) {
+        std::cerr << "Could not allocate analysis cache " << temporaryPath << std::endl;
+        ::close(handle);
+        unlink(temporaryPath.c_str());
+        return false;
+    }
+
+    AnalysisCacheHeader header = {};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.entrySize = sizeof(AnalysisEntry);
+    header.bucketCount = bucketCount;
+    std::memcpy(image, &header, sizeof(header));
+    AnalysisEntry *entries = reinterpret_cast<AnalysisEntry *>(static_cast<char *>(image) + sizeof(AnalysisCacheHeader));
+    for (size_t i = 0; i < contents.size(); i++)
+        insertEntry(entries, bucketCount, contents[i], false);
+
+    bool written = msync(image, size, MS_SYNC) == 0;
+    munmap(image, size);
+    written = (fsync(handle) == 0) && written;
+    ::close(handle);
+    if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Could not write analysis cache " << path << std::endl;
+        unlink(temporaryPath.c_str());
+        return false;
+    }
+    syncDirectory(path);
+    return true;
+}
+
+AnalysisCache::~AnalysisCache() {
+    close();
+}
+
+bool AnalysisCache::open(const std::string &path, size_t megabytes, bool readOnly) {
+    close();
+    file = ::open(path.c_str(), readOnly ? O_RDONLY : O_RDWR);
+    if (file < 0 && errno == ENOENT && !readOnly) {
+        if (!writeCacheFile(path, bucketsFor(megabytes), {}))
+            return false;
+        file = ::open(path.c_str(), O_RDWR);
+    }
+    if (file < 0) {
+        std::cerr << "Could not open analysis cache " << path << std::endl;
+        return false;
+    }
+
+    // Any number of readers, or a single writer
+    if (flock(file, (readOnly ? LOCK_SH : LOCK_EX) | LOCK_NB) != 0) {
+        std::cerr << "Analysis cache " << path << " is in use by another process" << std::endl;
+        close();
+        return false;
+    }
+
+    struct stat status;
+    AnalysisCacheHeader header;
+    if (fstat(file, &status) != 0 || pread(file, &header, sizeof(header), 0) != sizeof(header) ||
+        std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion ||
+        header.entrySize != sizeof(AnalysisEntry) || header.bucketCount == 0 || (header.bucketCount & (header.bucketCount - 1)) ||
+        header.bucketCount > static_cast<uint64_t>(status.st_size) ||
+        static_cast<uint64_t>(status.st_size) != sizeof(AnalysisCacheHeader) + header.bucketCount * BUCKET_BYTES) {
+        std::cerr << path << " is not an analysis cache" << std::endl;
+        close();
+        return false;
+    }
+
+    mappingSize = status.st_size;
+    mapping = mmap(nullptr, mappingSize, PROT_READ | (readOnly ? 0 : PROT_WRITE), MAP_SHARED, file, 0);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Could not map analysis cache " << path << std::endl;
+        mapping = nullptr;
+        close();
+        return false;
+    }
+    entries = reinterpret_cast<AnalysisEntry *>(static_cast<char *>(mapping) + sizeof(AnalysisCacheHeader));
+    bucketCount = header.bucketCount;
+    writable = !readOnly;
+    return true;
+}
+
+void AnalysisCache::close() {
+    if (mapping) {
+        if (writable)
+            msync(mapping, mappingSize, MS_SYNC);
+        munmap(mapping, mappingSize);
+    }
+    // Closing the descriptor releases the lock
+    if (file >= 0)
+        ::close(file);
+    file = -1;
+    mapping = nullptr;
+    mappingSize = 0;
+    entries = nullptr;
+    bucketCount = 0;
+    writable = false;
+}
+
+bool AnalysisCache::flush() {
+    return !mapping || !writable || msync(mapping, mappingSize, MS_SYNC) == 0;
+}
+
+uint64_t AnalysisCache::countEntries() const {
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < capacity(); i++)
+        count += entryValid(entries[i]);
+    return count;
+}
+
+bool AnalysisCache::probe(uint64_t key, AnalysisRecord &record) const {
+    if (!mapping)
+        return false;
+    const AnalysisEntry *bucket = entries + (key & (bucketCount - 1)) * BUCKET_SIZE;
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        AnalysisEntry entry = bucket[i];
+        if (entry.key != key || !entryValid(entry))
+            continue;
+        record = { entry.key, Move(entry.move), entry.score, entry.depth, static_cast<AnalysisKind>(entry.kind) };
+        return true;
+    }
+    return false;
+}
+
+void AnalysisCache::store(const AnalysisRecord &record) {
+    if (!mapping || !writable)
+        return;
+    AnalysisEntry entry = { record.key, record.bestMove.getEncoding(), record.score, record.depth, record.kind, 0 };
+    entry.checksum = entryChecksum(entry);
+    insertEntry(entries, bucketCount, entry, true);
+}
+
+bool compactAnalysisCache(const std::string &path, size_t megabytes) {
+    // Opening for reading takes a shared lock, which keeps writers out until the new file is in place
+    AnalysisCache cache;
+    if (!cache.open(path, 0, true))
+        return false;
+
+    // Deepest results first, so that those are the ones kept when the new file is too small for everything
+    std::vector<AnalysisEntry> contents;
+    for (uint64_t i = 0; i < cache.capacity(); i++)
+        if (entryValid(cache.entries[i]))
+            contents.push_back(cache.entries[i]);
+    std::stable_sort(contents.begin(), contents.end(), [](const AnalysisEntry &a, const AnalysisEntry &b) {
+        return a.depth > b.depth;
+    });
+
+    uint64_t bucketCount = megabytes ? bucketsFor(megabytes) : cache.bucketCount;
+    return writeCacheFile(path, bucketCount, contents);
+}
@@ -0,0 +1,91 @@
+#ifndef ANALYSIS_CACHE_H
+#define ANALYSIS_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "move.h"
+
+/*
+Persistent analysis cache: a hash table of analysed positions kept in a memory-mapped file, so that results survive
+from one run to the next and repeated analysis of the same positions starts warm.
+
+The file is a header followed by buckets of four 16-byte entries, one cache line each.
+A new position replaces the entry of the same position, an empty one, or else the one analysed to the lowest depth.
+Writes go straight to the mapping, so they persist if the process dies; to survive a machine crash as well,
+every entry carries a checksum over its contents and a torn entry simply reads as empty.
+New files and compacted ones are written in full under a temporary name and renamed into place,
+so the cache file on disk is always complete. A lock on the file keeps a second process from writing at the same time.
+*/
+
+// What an analysis result says about its position
+enum AnalysisKind : uint8_t {
+    AnalysisEmpty,
+    AnalysisMate, // score moves to mate, positive when the side to move mates and negative when it is mated
+    AnalysisShortestMate, // As AnalysisMate, with no shorter mate possible
+    AnalysisNoMate // No mate for the side to move within depth moves
+};
+
+struct AnalysisRecord {
+    uint64_t key;
+    Move bestMove;
+    int16_t score;
+    uint8_t depth;
+    AnalysisKind kind;
+};
+
+// Entry layout within the file
+struct AnalysisEntry {
+    uint64_t key;
+    uint16_t move;
+    int16_t score;
+    uint8_t depth;
+    uint8_t kind;
+    uint16_t checksum;
+};
+
+static_assert(sizeof(AnalysisEntry) == 16, "The entry layout is part of the file format");
+
+class AnalysisCache {
+private:
+    int file = -1;
+    void *mapping = nullptr;
+    size_t mappingSize = 0;
+    AnalysisEntry *entries = nullptr;
+    uint64_t bucketCount = 0;
+    bool writable = false;
+
+    friend bool compactAnalysisCache(const std::string &path, size_t megabytes);
+
+public:
+    static const int BUCKET_SIZE = 4;
+
+    AnalysisCache() = default;
+    AnalysisCache(const AnalysisCache &) = delete;
+    AnalysisCache &operator=(const AnalysisCache &) = delete;
+    ~AnalysisCache();
+
+    // Map a cache file, creating it with about the given number of megabytes if it does not exist yet
+    bool open(const std::string &path, size_t megabytes = 64, bool readOnly = false);
+    // Write everything out to disk and unmap the file
+    void close();
+    // Wait until every result stored so far is on disk
+    bool flush();
+
+    bool isOpen() const { return mapping != nullptr; }
+    uint64_t capacity() const { return bucketCount * BUCKET_SIZE; }
+    // Number of entries holding a valid result, which takes a pass over the whole file
+    uint64_t countEntries() const;
+
+    // Returns false when the position has no result
+    bool probe(uint64_t key, AnalysisRecord &record) const;
+    void store(const AnalysisRecord &record);
+};
+
+/*
+Rewrite a cache file with only its valid entries, resized to the given number of megabytes or kept at its size when zero.
+Entries that no longer fit are dropped, the shallowest first. The original stays in place until the new file is complete.
+*/
+bool compactAnalysisCache(const std::string &path, size_t megabytes = 0);
+
+#endif // ANALYSIS_CACHE_H
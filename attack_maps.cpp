@@ -0,0 +1,97 @@
+#include "attack_maps.h"
+#include "attacks.h"
+
+#ifdef ATTACK_MAPS_AVX2_AVAILABLE
+#include <immintrin.h>
+#endif
+
+AttackMapBackend attackMapBackend = ScalarAttackMaps;
+
+static Bitboard slidingAttackMapScalar(Bitboard orthogonalSliders, Bitboard diagonalSliders, Bitboard occupancy) {
+    Bitboard empty = ~occupancy;
+    return occludedAttacks<North>(orthogonalSliders, empty) | occludedAttacks<East>(orthogonalSliders, empty) |
+           occludedAttacks<South>(orthogonalSliders, empty) | occludedAttacks<West>(orthogonalSliders, empty) |
+           occludedAttacks<NorthEast>(diagonalSliders, empty) | occludedAttacks<NorthWest>(diagonalSliders, empty) |
+           occludedAttacks<SouthWest>(diagonalSliders, empty) | occludedAttacks<SouthEast>(diagonalSliders, empty);
+}
+
+#ifdef ATTACK_MAPS_AVX2_AVAILABLE
+/*
+Lanes, from lowest to highest, hold north, west, northeast and northwest for the left shifts,
+and south, east, southwest and southeast for the right shifts; both groups step by 8, 1, 7 and 9 bits.
+*/
+__attribute__((target("avx2")))
+static Bitboard slidingAttackMapAvx2(Bitboard orthogonalSliders, Bitboard diagonalSliders, Bitboard occupancy) {
+    const __m256i steps = _mm256_set_epi64x(9, 7, 1, 8);
+    const __m256i empty = _mm256_set1_epi64x(static_cast<long long>(~occupancy));
+    const __m256i sliders = _mm256_set_epi64x(diagonalSliders, diagonalSliders, orthogonalSliders, orthogonalSliders);
+    const __m256i leftTargets = _mm256_set_epi64x(shift(UNIVERSE, NorthWest), shift(UNIVERSE, NorthEast), shift(UNIVERSE, West), shift(UNIVERSE, North));
+    const __m256i rightTargets = _mm256_set_epi64x(shift(UNIVERSE, SouthEast), shift(UNIVERSE, SouthWest), shift(UNIVERSE, East), shift(UNIVERSE, South));
+
+    __m256i left = sliders, right = sliders;
+    __m256i leftPropagators = _mm256_and_si256(empty, leftTargets), rightPropagators = _mm256_and_si256(empty, rightTargets);
+    __m256i distance = steps;
+    for (int i = 0; i < 3; i++) {
+        left = _mm256_or_si256(left, _mm256_and_si256(leftPropagators, _mm256_sllv_epi64(left, distance)));
+        right = _mm256_or_si256(right, _mm256_and_si256(rightPropagators, _mm256_srlv_epi64(right, distance)));
+        leftPropagators = _mm256_and_si256(leftPropagators, _mm256_sllv_epi64(leftPropagators, distance));
+        rightPropagators = _mm256_and_si256(rightPropagators, _mm256_srlv_epi64(rightPropagators, distance));
+        distance = _mm256_add_epi64(distance, distance);
+    }
+    left = _mm256_and_si256(leftTargets, _mm256_sllv_epi64(left, steps));
+    right = _mm256_and_si256(rightTargets, _mm256_srlv_epi64(right, steps));
+
+    // Combine the eight directions into one bitboard
+    __m256i combined = _mm256_or_si256(left, right);
+    __m128i halves = _mm_or_si128(_mm256_castsi256_si128(combined), _mm256_extracti128_si256(combined, 1));
+    return static_cast<Bitboard>(_mm_cvtsi128_si64(halves) | _mm_extract_epi64(halves, 1));
+}
+#endif
+
+// Starts out scalar through constant initialization, so it is usable before the static initializer below has run
+static Bitboard (*slidingAttackMapImplementation)(Bitboard, Bitboard, Bitboard) = slidingAttackMapScalar;
+
+bool attackMapBackendSupported(AttackMapBackend backend) {
+#ifdef ATTACK_MAPS_AVX2_AVAILABLE
+    __builtin_cpu_init();
+    if (backend == Avx2AttackMaps)
+        return __builtin_cpu_supports("avx2");
+#endif
+    return backend == ScalarAttackMaps;
+}
+
+const char *attackMapBackendName(AttackMapBackend backend) {
+    return (backend == Avx2AttackMaps) ? "avx2" : "scalar";
+}
+
+bool setAttackMapBackend(AttackMapBackend backend) {
+    if (!attackMapBackendSupported(backend))
+        return false;
+#ifdef ATTACK_MAPS_AVX2_AVAILABLE
+    if (backend == Avx2AttackMaps) {
+        attackMapBackend = backend;
+        slidingAttackMapImplementation = slidingAttackMapAvx2;
+        return true;
+    }
+#endif
+    attackMapBackend = backend;
+    slidingAttackMapImplementation = slidingAttackMapScalar;
+    return true;
+}
+
+// Picks the fastest backend the CPU supports
+static struct AttackMapInitializer {
+    AttackMapInitializer() {
+        setAttackMapBackend(Avx2AttackMaps);
+    }
+} attackMapInitializer;
+
+Bitboard slidingAttackMap(Bitboard orthogonalSliders, Bitboard diagonalSliders, Bitboard occupancy) {
+    return slidingAttackMapImplementation(orthogonalSliders, diagonalSliders, occupancy);
+}
+
+Bitboard attackMap(const Position &position, Color color) {
+    const Bitboard *pieces = position.pieces[color];
+    return pawnAttackSet(color, pieces[Pawn]) | knightAttackSet(pieces[Knight]) | kingAttackSet(pieces[King]) |
+           slidingAttackMap(pieces[Rook] | pieces[Queen], pieces[Bishop] | pieces[Queen], position.allPieces);
+}
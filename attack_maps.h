@@ -0,0 +1,78 @@
+#ifndef ATTACK_MAPS_H
+#define ATTACK_MAPS_H
+
+#include "attacks.h"
+#include "bitboard.h"
+#include "position.h"
+#include "types.h"
+
+/*
+Whole-board attack maps, for evaluation terms such as mobility, king safety and space.
+Rather than looking up each piece's attacks and combining them, every piece of a kind is handled at once:
+the sliders of both kinds are flooded along their rays with Kogge-Stone occluded fills, which take three doubling steps per direction.
+The eight ray directions split into four that shift left and four that shift right by the same amounts,
+so with AVX2 each group runs as the four lanes of a single vector; other CPUs use the scalar fill.
+More information can be found here:
+https://www.chessprogramming.org/Kogge-Stone_Algorithm
+*/
+enum AttackMapBackend {
+    ScalarAttackMaps,
+    Avx2AttackMaps
+};
+
+// Backend used by every set-wise routine, chosen by the static initializer in attack_maps.cpp
+extern AttackMapBackend attackMapBackend;
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ATTACK_MAPS_AVX2_AVAILABLE
+#endif
+
+// Whether this CPU can run a backend at all
+bool attackMapBackendSupported(AttackMapBackend backend);
+// Name of a backend for reports
+const char *attackMapBackendName(AttackMapBackend backend);
+// Switch to another backend, returning false if the CPU does not support it
+bool setAttackMapBackend(AttackMapBackend backend);
+
+/*
+The fills below work on a single bitboard or on a GCC vector of bitboards from several positions alike,
+since they only use shifts and bitwise operations. They are forced inline so that vector code built for AVX2 stays AVX2 throughout.
+*/
+#define ATTACK_MAPS_INLINE inline __attribute__((always_inline))
+
+// Shift by any number of steps in a direction, without the boundary checks of the one-step helpers
+template<int Direction, typename Lanes>
+ATTACK_MAPS_INLINE Lanes shiftBy(Lanes bitboards, int steps) {
+    constexpr int amount[8] = { 8, -1, -8, 1, 7, 9, -7, -9 };
+    return (amount[Direction] > 0) ? bitboards << (amount[Direction] * steps) : bitboards >> (-amount[Direction] * steps);
+}
+
+// One step in a direction, dropping anything that would wrap around the board like the one-step helpers do
+template<int Direction, typename Lanes>
+ATTACK_MAPS_INLINE Lanes step(Lanes bitboards) {
+    return shiftBy<Direction>(bitboards, 1) & shift(UNIVERSE, Direction);
+}
+
+/*
+Flood sliders along one direction through empty squares, then take one more step to reach the first blocker.
+Empty squares on the file or rank a step would wrap around from are removed from the propagators up front,
+which is what the one-step helper does for a single shift; shift(UNIVERSE, direction) is exactly the squares a step can land on.
+*/
+template<int Direction, typename Lanes>
+ATTACK_MAPS_INLINE Lanes occludedAttacks(Lanes sliders, Lanes empty) {
+    Lanes propagators = empty & shift(UNIVERSE, Direction);
+    sliders |= propagators & shiftBy<Direction>(sliders, 1);
+    propagators &= shiftBy<Direction>(propagators, 1);
+    sliders |= propagators & shiftBy<Direction>(sliders, 2);
+    propagators &= shiftBy<Direction>(propagators, 2);
+    sliders |= propagators & shiftBy<Direction>(sliders, 4);
+    return step<Direction>(sliders);
+}
+
+// Squares attacked by any of the orthogonal sliders and any of the diagonal sliders given, with queens belonging to both sets
+Bitboard slidingAttackMap(Bitboard orthogonalSliders, Bitboard diagonalSliders, Bitboard occupancy);
+
+// Squares attacked by every piece of one side
+Bitboard attackMap(const Position &position, Color color);
+
+#endif // ATTACK_MAPS_H
@@ -0,0 +1,102 @@
+#include "attacks.h"
+#include "magic_bitboards.h"
+#include "memory.h"
+
+SliderBackend sliderBackend = MagicSliders;
+Magic rookMagicTable[64];
+Magic bishopMagicTable[64];
+
+// Rook tables need 2^12 entries on the corners down to 2^10 elsewhere, bishops at most 2^9
+const int ROOK_TABLE_SIZE = 102400;
+const int BISHOP_TABLE_SIZE = 5248;
+// Both tables share one huge page, so every slider lookup is translated by the same TLB entry.
+// They are never freed, since lookups may still run on other threads while the program exits
+static LargeAllocation sliderTables;
+
+static const int rookDirections[4] = { North, East, South, West };
+static const int bishopDirections[4] = { NorthEast, NorthWest, SouthWest, SouthEast };
+
+Bitboard slidingAttacks(Square square, Bitboard occupancy, const int *directions, int directionCount) {
+    Bitboard attacks = 0ULL;
+    for (int i = 0; i < directionCount; i++) {
+        Bitboard ray = shift(BITBOARD(square), directions[i]);
+        while (ray) {
+            attacks |= ray;
+            // Stop once a piece is hit
+            if (ray & occupancy)
+                break;
+            ray = shift(ray, directions[i]);
+        }
+    }
+    return attacks;
+}
+
+/*
+Fill in one piece type's magic entries and attack tables.
+The relevant blockers are the squares a piece slides over, excluding the edge of the board in each direction,
+since a piece on the last square of a ray never blocks anything further along it.
+Every subset of the blockers is enumerated with the Carry-Rippler trick and its attacks stored at the magic index.
+*/
+static void initializeMagics(Magic *table, Bitboard *attacks, const Bitboard *magics, const int *directions) {
+    Bitboard *nextAttacks = attacks;
+    for (int square = 0; square < 64; square++) {
+        Magic &entry = table[square];
+        Bitboard edges = ((RANK_1 | RANK_8) & ~(square / 8 == 0 ? RANK_1 : square / 8 == 7 ? RANK_8 : 0ULL)) |
+                         ((FILE_A | FILE_H) & ~(square % 8 == 7 ? FILE_A : square % 8 == 0 ? FILE_H : 0ULL));
+        entry.mask = slidingAttacks(static_cast<Square>(square), 0ULL, directions, 4) & ~edges;
+        entry.magic = magics[square];
+        entry.shift = 64 - COUNT_BITS(entry.mask);
+        entry.attacks = nextAttacks;
+
+        Bitboard subset = 0ULL;
+        do {
+            nextAttacks[entry.index(subset)] = slidingAttacks(static_cast<Square>(square), subset, directions, 4);
+            subset = (subset - entry.mask) & entry.mask;
+        } while (subset);
+        nextAttacks += 1ULL << (64 - entry.shift);
+    }
+}
+
+bool sliderBackendSupported(SliderBackend backend) {
+#ifdef SLIDER_PEXT_AVAILABLE
+    // CPU detection may not have run yet when this is reached from a static initializer
+    __builtin_cpu_init();
+    if (backend == PextSliders)
+        return __builtin_cpu_supports("bmi2");
+#endif
+    return backend == MagicSliders;
+}
+
+const char *sliderBackendName(SliderBackend backend) {
+    return (backend == PextSliders) ? "pext" : "magic";
+}
+
+bool setSliderBackend(SliderBackend backend) {
+    if (!sliderBackendSupported(backend))
+        return false;
+    // The index function depends on the backend, so the tables are laid out again with the new one
+    sliderBackend = backend;
+    if (!sliderTables.memory)
+        sliderTables = allocateLarge((ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE) * sizeof(Bitboard), MemorySliderTables);
+    Bitboard *tables = static_cast<Bitboard *>(sliderTables.memory);
+    initializeMagics(rookMagicTable, tables, rookMagics, rookDirections);
+    initializeMagics(bishopMagicTable, tables + ROOK_TABLE_SIZE, bishopMagics, bishopDirections);
+    return true;
+}
+
+/*
+Builds the sliding piece tables once, during static initialization.
+PEXT is preferred wherever BMI2 exists, except on AMD CPUs before Zen 3, which implement it in microcode
+at a cost of dozens of cycles and are faster with magic multiplication.
+*/
+static struct AttackTableInitializer {
+    AttackTableInitializer() {
+        bool slowPext = false;
+#ifdef SLIDER_PEXT_AVAILABLE
+        __builtin_cpu_init();
+        slowPext = __builtin_cpu_is("amdfam17h");
+#endif
+        if (slowPext || !setSliderBackend(PextSliders))
+            setSliderBackend(MagicSliders);
+    }
+} attackTableInitializer;
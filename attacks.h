@@ -0,0 +1,226 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include <array>
+#include "bitboard.h"
+#include "types.h"
+
+/*
+Precomputed attack and geometry tables.
+Everything that depends only on the square is computed at compile time, so the tables are read-only data shared by every thread.
+The sliding piece tables depend on blockers as well and are too large to build at compile time;
+they are filled in exactly once by a static initializer in attacks.cpp, before main runs and before any thread can exist.
+*/
+
+// Ray directions in the order used by the ray table
+enum Direction {
+    North,
+    East,
+    South,
+    West,
+    NorthEast,
+    NorthWest,
+    SouthWest,
+    SouthEast
+};
+
+// Shift a bitboard one step in a direction using the boundary-checked helpers
+constexpr Bitboard shift(Bitboard bitboard, int direction) {
+    switch (direction) {
+        case North: return north(bitboard);
+        case East: return east(bitboard);
+        case South: return south(bitboard);
+        case West: return west(bitboard);
+        case NorthEast: return northeast(bitboard);
+        case NorthWest: return northwest(bitboard);
+        case SouthWest: return southwest(bitboard);
+        default: return southeast(bitboard);
+    }
+}
+
+typedef std::array<Bitboard, 64> SquareTable;
+typedef std::array<SquareTable, 64> SquarePairTable;
+
+/*
+Set-wise leaper attacks: every square attacked by any piece in a set, computed with shifts instead of per-square lookups.
+They also generate the per-square tables below from single-square sets.
+*/
+// Kings can attack in any adjacent square
+constexpr Bitboard kingAttackSet(Bitboard kings) {
+    Bitboard attacks = 0ULL;
+    for (int direction = North; direction <= SouthEast; direction++)
+        attacks |= shift(kings, direction);
+    return attacks;
+}
+
+// Knights can attack in an L shape
+constexpr Bitboard knightAttackSet(Bitboard knights) {
+    return (((knights & ~(FILE_G | FILE_H | RANK_8)) << 6) | ((knights & ~(FILE_G | FILE_H | RANK_1)) >> 10)) |
+           (((knights & ~(FILE_H | RANK_7 | RANK_8)) << 15) | ((knights & ~(FILE_H | RANK_1 | RANK_2)) >> 17)) |
+           (((knights & ~(FILE_A | RANK_7 | RANK_8)) << 17) | ((knights & ~(FILE_A | RANK_1 | RANK_2)) >> 15)) |
+           (((knights & ~(FILE_A | FILE_B | RANK_8)) << 10) | ((knights & ~(FILE_A | FILE_B | RANK_1)) >> 6));
+}
+
+// Pawns capture diagonally forward
+constexpr Bitboard pawnAttackSet(Color color, Bitboard pawns) {
+    return (color == White) ? (northeast(pawns) | northwest(pawns)) : (southeast(pawns) | southwest(pawns));
+}
+
+constexpr SquareTable makeKingAttacks() {
+    SquareTable table = {};
+    for (int square = 0; square < 64; square++)
+        table[square] = kingAttackSet(BITBOARD(square));
+    return table;
+}
+
+constexpr SquareTable makeKnightAttacks() {
+    SquareTable table = {};
+    for (int square = 0; square < 64; square++)
+        table[square] = knightAttackSet(BITBOARD(square));
+    return table;
+}
+
+// Pawns can advance forward or capture diagonally forward
+constexpr std::array<SquareTable, 2> makePawnAdvances() {
+    std::array<SquareTable, 2> table = {};
+    for (int square = 0; square < 64; square++) {
+        table[White][square] = north(BITBOARD(square));
+        table[Black][square] = south(BITBOARD(square));
+    }
+    return table;
+}
+
+constexpr std::array<SquareTable, 2> makePawnCaptures() {
+    std::array<SquareTable, 2> table = {};
+    for (int square = 0; square < 64; square++) {
+        table[White][square] = pawnAttackSet(White, BITBOARD(square));
+        table[Black][square] = pawnAttackSet(Black, BITBOARD(square));
+    }
+    return table;
+}
+
+// Squares reached by sliding from a square in one direction on an empty board
+constexpr std::array<SquareTable, 8> makeRays() {
+    std::array<SquareTable, 8> table = {};
+    for (int direction = North; direction <= SouthEast; direction++) {
+        for (int square = 0; square < 64; square++) {
+            Bitboard ray = shift(BITBOARD(square), direction);
+            while (ray) {
+                table[direction][square] |= ray;
+                ray = shift(ray, direction);
+            }
+        }
+    }
+    return table;
+}
+
+// For every pair of aligned squares, the squares strictly between them (between) or the whole line through them (line)
+constexpr SquarePairTable makeAlignmentTable(bool wholeLine) {
+    constexpr std::array<SquareTable, 8> rays = makeRays();
+    SquarePairTable table = {};
+    for (int from = 0; from < 64; from++) {
+        for (int direction = North; direction <= SouthEast; direction++) {
+            // Each direction pairs with the opposite one: N/S, E/W, NE/SW, NW/SE
+            int opposite = (direction < NorthEast) ? (direction + 2) % 4 : NorthEast + (direction - NorthEast + 2) % 4;
+            Bitboard ray = rays[direction][from];
+            while (ray) {
+                int to = GET_LSB(ray);
+                ray &= ray - 1;
+                table[from][to] = wholeLine ? (rays[direction][from] | rays[opposite][from] | BITBOARD(from))
+                                            : (rays[direction][from] & rays[opposite][to]);
+            }
+        }
+    }
+    return table;
+}
+
+// Leaping piece tables
+inline constexpr SquareTable kingAttacks = makeKingAttacks();
+inline constexpr SquareTable knightAttacks = makeKnightAttacks();
+inline constexpr std::array<SquareTable, 2> pawnAdvances = makePawnAdvances();
+inline constexpr std::array<SquareTable, 2> pawnCaptures = makePawnCaptures();
+
+// Geometry tables: rays on an empty board, squares between two aligned squares, and the full line through them
+inline constexpr std::array<SquareTable, 8> rays = makeRays();
+inline constexpr SquarePairTable betweenSquares = makeAlignmentTable(false);
+inline constexpr SquarePairTable lineSquares = makeAlignmentTable(true);
+
+/*
+Sliding piece lookups index a table of attacks by the relevant blockers of a square.
+Two backends compute the index, and both fill tables of exactly the same size:
+- Magic multiplies the blockers by the magic number of the square from magic_bitboards.h and keeps the top bits of the product.
+- PEXT gathers the blockers into the low bits with the BMI2 parallel bit extract instruction, needing neither a multiply nor a magic number.
+The backend is picked once at startup from CPUID, so one binary runs on every x86-64 machine.
+More information can be found here:
+https://www.chessprogramming.org/BMI2#PEXTBitboards
+*/
+enum SliderBackend {
+    MagicSliders,
+    PextSliders
+};
+
+// Backend used by every lookup, chosen by the static initializer in attacks.cpp
+extern SliderBackend sliderBackend;
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SLIDER_PEXT_AVAILABLE
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+// Parallel bit extract; written as inline assembly unless BMI2 is enabled for the whole build, so that it can be inlined anywhere
+inline Bitboard parallelExtract(Bitboard bitboard, Bitboard mask) {
+#ifdef __BMI2__
+    return _pext_u64(bitboard, mask);
+#else
+    Bitboard result;
+    asm("pextq %2, %1, %0" : "=r"(result) : "r"(bitboard), "r"(mask));
+    return result;
+#endif
+}
+#endif
+
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    const Bitboard *attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupancy) const {
+#ifdef SLIDER_PEXT_AVAILABLE
+        // The backend never changes while moves are generated, so this branch is always predicted
+        if (sliderBackend == PextSliders)
+            return static_cast<unsigned>(parallelExtract(occupancy, mask));
+#endif
+        return static_cast<unsigned>(((occupancy & mask) * magic) >> shift);
+    }
+};
+
+extern Magic rookMagicTable[64];
+extern Magic bishopMagicTable[64];
+
+// Whether this CPU can run a backend at all
+bool sliderBackendSupported(SliderBackend backend);
+// Name of a backend for reports
+const char *sliderBackendName(SliderBackend backend);
+// Rebuild the sliding piece tables for another backend, returning false if the CPU does not support it; no thread may be generating moves meanwhile
+bool setSliderBackend(SliderBackend backend);
+
+inline Bitboard rookAttacks(Square square, Bitboard occupancy) {
+    const Magic &entry = rookMagicTable[square];
+    return entry.attacks[entry.index(occupancy)];
+}
+
+inline Bitboard bishopAttacks(Square square, Bitboard occupancy) {
+    const Magic &entry = bishopMagicTable[square];
+    return entry.attacks[entry.index(occupancy)];
+}
+
+inline Bitboard queenAttacks(Square square, Bitboard occupancy) {
+    return rookAttacks(square, occupancy) | bishopAttacks(square, occupancy);
+}
+
+// Slow reference implementation that walks each ray until it hits a blocker, used to build the tables
+Bitboard slidingAttacks(Square square, Bitboard occupancy, const int *directions, int directionCount);
+
+#endif // ATTACKS_H
@@ -0,0 +1,374 @@
+/*
+Microbenchmarks for the core board operations.
+Each benchmark runs over a fixed set of positions so that results are comparable between runs and machines.
+After warming up, every benchmark is calibrated to run for at least a minimum time per repetition,
+and the minimum and median time per operation across repetitions is reported.
+The sliding attack lookups and attack maps are timed once per backend the CPU supports; everything else uses the backends picked at startup.
+
+Usage: benchmark [--repetitions N] [--warmup N] [--min-time MS] [--filter TEXT] [--json FILE]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../attack_maps.h"
+#include "../attacks.h"
+#include "../chessboard.h"
+#include "../position_batch.h"
+#include "../move.h"
+#include "../types.h"
+
+// Positions covering the opening, tactical middlegames, checks and endgames
+static const char *benchmarkPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 b - - 0 1",
+    "r1bqkb1r/pppp1Qpp/2n2n2/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4"
+};
+
+struct BenchmarkOptions {
+    int repetitions = 10;
+    int warmup = 3;
+    double minTimeMs = 50.0;
+    std::string filter;
+    std::string jsonFile;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    uint64_t operationsPerRound;
+    uint64_t roundsPerRepetition;
+    std::vector<double> samples; // Nanoseconds per operation, one per repetition
+    double min;
+    double median;
+};
+
+// A benchmark performs one round over every position and returns the number of operations it timed
+struct Benchmark {
+    std::string name;
+    std::function<uint64_t()> round;
+    // Sliding attack backend the benchmark runs with, defaulting to the one picked at startup
+    SliderBackend backend = sliderBackend;
+};
+
+// Results are folded into this value so the compiler cannot discard the work being timed
+static volatile uint64_t sink;
+
+static double elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static BenchmarkResult runBenchmark(const Benchmark &benchmark, const BenchmarkOptions &options) {
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.operationsPerRound = 0;
+
+    // Warm up caches and branch predictors, timing the last round to calibrate the repetition length
+    double roundNs = 0;
+    for (int i = 0; i < std::max(options.warmup, 1); i++) {
+        auto start = std::chrono::steady_clock::now();
+        result.operationsPerRound = benchmark.round();
+        roundNs = elapsedNs(start);
+    }
+    result.roundsPerRepetition = std::max<uint64_t>(1, static_cast<uint64_t>(options.minTimeMs * 1e6 / std::max(roundNs, 1.0)));
+
+    for (int repetition = 0; repetition < options.repetitions; repetition++) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t round = 0; round < result.roundsPerRepetition; round++)
+            benchmark.round();
+        result.samples.push_back(elapsedNs(start) / (result.roundsPerRepetition * std::max<uint64_t>(result.operationsPerRound, 1)));
+    }
+
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    result.min = sorted.front();
+    result.median = (sorted.size() % 2) ? sorted[sorted.size() / 2] : (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2;
+    return result;
+}
+
+static bool writeJSON(const std::string &path, const std::vector<BenchmarkResult> &results, const BenchmarkOptions &options, int positions,
+                      SliderBackend backend) {
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "{\n  \"positions\": %d,\n  \"repetitions\": %d,\n  \"warmup\": %d,\n  \"min_time_ms\": %.1f,\n  \"slider_backend\": \"%s\",\n  \"benchmarks\": [\n",
+                 positions, options.repetitions, options.warmup, options.minTimeMs, sliderBackendName(backend));
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult &result = results[i];
+        std::fprintf(file, "    {\"name\": \"%s\", \"operations_per_round\": %llu, \"rounds_per_repetition\": %llu, \"min_ns\": %.3f, \"median_ns\": %.3f, \"samples_ns\": [",
+                     result.name.c_str(), static_cast<unsigned long long>(result.operationsPerRound),
+                     static_cast<unsigned long long>(result.roundsPerRepetition), result.min, result.median);
+        for (size_t j = 0; j < result.samples.size(); j++)
+            std::fprintf(file, "%s%.3f", j ? ", " : "", result.samples[j]);
+        std::fprintf(file, "]}%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "Missing value for %s\n", option.c_str());
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (option == "--repetitions")
+            options.repetitions = std::max(1, std::stoi(value));
+        else if (option == "--warmup")
+            options.warmup = std::max(0, std::stoi(value));
+        else if (option == "--min-time")
+            options.minTimeMs = std::stod(value);
+        else if (option == "--filter")
+            options.filter = value;
+        else if (option == "--json")
+            options.jsonFile = value;
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    // Set up the positions and the moves played from each of them once, outside of any timing
+    std::vector<Chessboard> boards;
+    std::vector<MoveList> moves;
+    for (const char *fen : benchmarkPositions) {
+        Chessboard chessboard;
+        if (!chessboard.loadFEN(fen)) {
+            std::fprintf(stderr, "Invalid benchmark position %s\n", fen);
+            return 1;
+        }
+        moves.push_back(chessboard.generateLegalMoves());
+        boards.push_back(chessboard);
+    }
+
+    std::vector<Benchmark> benchmarks = {
+        {"push_pop", [&]() {
+            uint64_t operations = 0;
+            for (size_t i = 0; i < boards.size(); i++) {
+                for (size_t j = 0; j < moves[i].size(); j++) {
+                    boards[i].push(moves[i][j]);
+                    boards[i].pop();
+                }
+                operations += moves[i].size();
+            }
+            sink = sink + boards[0].allPieces;
+            return operations;
+        }},
+        {"givesCheck", [&]() {
+            uint64_t total = 0, operations = 0;
+            for (size_t i = 0; i < boards.size(); i++) {
+                for (size_t j = 0; j < moves[i].size(); j++)
+                    total += boards[i].givesCheck(moves[i][j]);
+                operations += moves[i].size();
+            }
+            sink = sink + total;
+            return operations;
+        }},
+        // The same question answered by playing each move, for comparison
+        {"givesCheck/push_pop", [&]() {
+            uint64_t total = 0, operations = 0;
+            for (size_t i = 0; i < boards.size(); i++) {
+                for (size_t j = 0; j < moves[i].size(); j++) {
+                    boards[i].push(moves[i][j]);
+                    total += boards[i].isCheck();
+                    boards[i].pop();
+                }
+                operations += moves[i].size();
+            }
+            sink = sink + total;
+            return operations;
+        }},
+        // Moves of the next position as well as this one's, so that some are rejected as a stale hash move would be
+        {"isLegal", [&]() {
+            uint64_t total = 0, operations = 0;
+            for (size_t i = 0; i < boards.size(); i++) {
+                const MoveList &other = moves[(i + 1) % boards.size()];
+                for (size_t j = 0; j < moves[i].size(); j++)
+                    total += boards[i].isLegal(moves[i][j]);
+                for (size_t j = 0; j < other.size(); j++)
+                    total += boards[i].isLegal(other[j]);
+                operations += moves[i].size() + other.size();
+            }
+            sink = sink + total;
+            return operations;
+        }},
+        {"pieceAt", [&]() {
+            uint64_t total = 0;
+            for (size_t i = 0; i < boards.size(); i++)
+                for (int square = 0; square < 64; square++)
+                    total += boards[i].pieceAt(static_cast<Square>(square));
+            sink = sink + total;
+            return static_cast<uint64_t>(boards.size() * 64);
+        }},
+        {"generatePseudoLegalMoves", [&]() {
+            uint64_t total = 0;
+            for (size_t i = 0; i < boards.size(); i++)
+                total += boards[i].generatePseudoLegalMoves().size();
+            sink = sink + total;
+            return static_cast<uint64_t>(boards.size());
+        }},
+        {"generateLegalMoves", [&]() {
+            uint64_t total = 0;
+            for (size_t i = 0; i < boards.size(); i++)
+                total += boards[i].generateLegalMoves().size();
+            sink = sink + total;
+            return static_cast<uint64_t>(boards.size());
+        }},
+        {"countLegalMoves", [&]() {
+            uint64_t total = 0;
+            for (size_t i = 0; i < boards.size(); i++)
+                total += boards[i].countLegalMoves();
+            sink = sink + total;
+            return static_cast<uint64_t>(boards.size());
+        }},
+        {"hasLegalMove", [&]() {
+            uint64_t total = 0;
+            for (size_t i = 0; i < boards.size(); i++)
+                total += boards[i].hasLegalMove();
+            sink = sink + total;
+            return static_cast<uint64_t>(boards.size());
+        }},
+        {"isCheck", [&]() {
+            uint64_t total = 0;
+            for (size_t i = 0; i < boards.size(); i++)
+                total += boards[i].isCheck();
+            sink = sink + total;
+            return static_cast<uint64_t>(boards.size());
+        }},
+        // A fresh board per query, so that the attack cache starts out empty
+        {"isCheck/cold", [&]() {
+            uint64_t total = 0;
+            for (size_t i = 0; i < boards.size(); i++) {
+                Chessboard board(static_cast<const Position &>(boards[i]));
+                total += board.isCheck();
+            }
+            sink = sink + total;
+            return static_cast<uint64_t>(boards.size());
+        }},
+        {"isCheckmate", [&]() {
+            uint64_t total = 0;
+            for (size_t i = 0; i < boards.size(); i++)
+                total += boards[i].isCheckmate();
+            sink = sink + total;
+            return static_cast<uint64_t>(boards.size());
+        }},
+        {"gameStatus", [&]() {
+            uint64_t total = 0;
+            MoveList legalMoves;
+            for (size_t i = 0; i < boards.size(); i++)
+                total += static_cast<int>(boards[i].gameStatus(legalMoves)) + legalMoves.size();
+            sink = sink + total;
+            return static_cast<uint64_t>(boards.size());
+        }}
+    };
+
+    // Time the sliding piece lookups alone with every backend this CPU supports, on the occupancies of the benchmark positions
+    for (SliderBackend backend : { MagicSliders, PextSliders }) {
+        if (!sliderBackendSupported(backend))
+            continue;
+        Benchmark benchmark = {std::string("sliderAttacks/") + sliderBackendName(backend), [&]() {
+            uint64_t total = 0;
+            for (size_t i = 0; i < boards.size(); i++) {
+                Bitboard occupancy = boards[i].allPieces;
+                for (int square = 0; square < 64; square++)
+                    total ^= rookAttacks(static_cast<Square>(square), occupancy) ^ bishopAttacks(static_cast<Square>(square), occupancy);
+            }
+            sink = sink + total;
+            return static_cast<uint64_t>(boards.size() * 64);
+        }};
+        benchmark.backend = backend;
+        benchmarks.push_back(benchmark);
+    }
+
+    // Whole-board attack maps of both sides, set-wise with each backend and piece by piece through the lookup tables for reference
+    for (AttackMapBackend backend : { ScalarAttackMaps, Avx2AttackMaps }) {
+        if (!attackMapBackendSupported(backend))
+            continue;
+        benchmarks.push_back({std::string("attackMap/") + attackMapBackendName(backend), [&, backend]() {
+            setAttackMapBackend(backend);
+            uint64_t total = 0;
+            for (size_t i = 0; i < boards.size(); i++)
+                total ^= attackMap(boards[i], White) ^ attackMap(boards[i], Black);
+            sink = sink + total;
+            return static_cast<uint64_t>(boards.size() * 2);
+        }});
+    }
+    benchmarks.push_back({"attackMap/lookup", [&]() {
+        uint64_t total = 0;
+        for (size_t i = 0; i < boards.size(); i++) {
+            for (int color = White; color <= Black; color++) {
+                const Bitboard *pieces = boards[i].pieces[color];
+                Bitboard attacks = pawnAttackSet(static_cast<Color>(color), pieces[Pawn]) | kingAttacks[GET_LSB(pieces[King])];
+                for (Bitboard knights = pieces[Knight]; knights;)
+                    attacks |= knightAttacks[POP_LSB(knights)];
+                for (Bitboard sliders = pieces[Rook] | pieces[Queen]; sliders;)
+                    attacks |= rookAttacks(static_cast<Square>(POP_LSB(sliders)), boards[i].allPieces);
+                for (Bitboard sliders = pieces[Bishop] | pieces[Queen]; sliders;)
+                    attacks |= bishopAttacks(static_cast<Square>(POP_LSB(sliders)), boards[i].allPieces);
+                total ^= attacks;
+            }
+        }
+        sink = sink + total;
+        return static_cast<uint64_t>(boards.size() * 2);
+    }});
+
+    // Bulk analysis of many positions at once, reported per position, with the positions repeated to fill a realistic batch
+    PositionBatch batch;
+    for (int copy = 0; copy < 100; copy++)
+        for (const Chessboard &board : boards)
+            batch.push_back(board);
+    BatchAnalysis analysis;
+    for (AttackMapBackend backend : { ScalarAttackMaps, Avx2AttackMaps }) {
+        if (!attackMapBackendSupported(backend))
+            continue;
+        benchmarks.push_back({std::string("analyzeBatch/") + attackMapBackendName(backend), [&, backend]() {
+            setAttackMapBackend(backend);
+            analyzeBatch(batch, analysis);
+            sink = sink + analysis.legalMoveCounts[0];
+            return static_cast<uint64_t>(batch.size());
+        }});
+    }
+
+    const SliderBackend defaultBackend = sliderBackend;
+    const AttackMapBackend defaultAttackMapBackend = attackMapBackend;
+    std::printf("Sliding attacks: %s\n", sliderBackendName(defaultBackend));
+
+    std::vector<BenchmarkResult> results;
+    std::printf("%-26s %14s %14s %12s\n", "benchmark", "min ns/op", "median ns/op", "ops/rep");
+    for (const Benchmark &benchmark : benchmarks) {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+            continue;
+        if (benchmark.backend != sliderBackend)
+            setSliderBackend(benchmark.backend);
+        BenchmarkResult result = runBenchmark(benchmark, options);
+        std::printf("%-26s %14.1f %14.1f %12llu\n", result.name.c_str(), result.min, result.median,
+                    static_cast<unsigned long long>(result.operationsPerRound * result.roundsPerRepetition));
+        std::fflush(stdout);
+        results.push_back(result);
+    }
+    if (sliderBackend != defaultBackend)
+        setSliderBackend(defaultBackend);
+    setAttackMapBackend(defaultAttackMapBackend);
+
+    if (!options.jsonFile.empty() && !writeJSON(options.jsonFile, results, options, boards.size(), defaultBackend)) {
+        std::fprintf(stderr, "Could not write %s\n", options.jsonFile.c_str());
+        return 1;
+    }
+    return 0;
+}
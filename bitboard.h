@@ -30,16 +30,20 @@ const Bitboard RANK_6 = 0x0000FF0000000000ULL;
 const Bitboard RANK_7 = 0x00FF000000000000ULL;
 const Bitboard RANK_8 = 0xFF00000000000000ULL;
 
+// Square color masks, with a1 dark and h1 light
+const Bitboard DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+const Bitboard LIGHT_SQUARES = ~DARK_SQUARES;
+
 // General masks
 const Bitboard EMPTY = 0ULL;
 const Bitboard UNIVERSE = 0xFFFFFFFFFFFFFFFFULL;
 
 // Set a bit at a given position to 1
-#define SET_BIT(bitboard, bit) ((bitboard) |= (1ULL << bit))
+#define SET_BIT(bitboard, bit) ((bitboard) |= (1ULL << (bit)))
 // Set a bit at a given position to 0
-#define CLEAR_BIT(bitboard, bit) ((bitboard) &= ~(1ULL << bit))
+#define CLEAR_BIT(bitboard, bit) ((bitboard) &= ~(1ULL << (bit)))
 // Get the value of a bit at a given position
-#define GET_BIT(bitboard, bit) ((bitboard) & (1ULL << bit))
+#define GET_BIT(bitboard, bit) ((bitboard) & (1ULL << (bit)))
 // Get the number of trailing zeros after the least significant bit
 #define GET_LSB(bitboard) (__builtin_ctzll(bitboard))
 // Clear the LSB and return its index
@@ -53,15 +57,8 @@ inline int POP_LSB(Bitboard &bitboard) {
     bitboard &= bitboard - 1;
     return index;
 }
-inline int COUNT_BITS(Bitboard bitboard) {
-    int bits = 0;
-    while (bitboard != 0) {
-        POP_LSB(bitboard);
-        bits++;
-    }
-    return bits;
-}
-#define BITBOARD(square) ((1ULL << square))
+inline int COUNT_BITS(Bitboard bitboard) { return __builtin_popcountll(bitboard); }
+#define BITBOARD(square) (1ULL << (square))
 
 // Directional helper functions with boundary validation
 constexpr Bitboard north(Bitboard bitboard) { return (bitboard & ~RANK_8) << 8; }
@@ -24,33 +24,12 @@ void printChessboard(Chessboard &chessboard) {
         for (int file = 7; file >= 0; file--) {
             int square = rank * 8 + file;
             Bitboard mask = BITBOARD(square);
-            // Find the piece on the square and print it
-            if (chessboard.whitePawns & mask)
-                std::cout << "P ";
-            else if (chessboard.whiteKnights & mask)
-                std::cout << "N ";
-            else if (chessboard.whiteBishops & mask)
-                std::cout << "B ";
-            else if (chessboard.whiteRooks & mask)
-                std::cout << "R ";
-            else if (chessboard.whiteQueen & mask)
-                std::cout << "Q ";
-            else if (chessboard.whiteKing & mask)
-                std::cout << "K ";
-            else if (chessboard.blackPawns & mask)
-                std::cout << "p ";
-            else if (chessboard.blackKnights & mask)
-                std::cout << "n ";
-            else if (chessboard.blackBishops & mask)
-                std::cout << "b ";
-            else if (chessboard.blackRooks & mask)
-                std::cout << "r ";
-            else if (chessboard.blackQueen & mask)
-                std::cout << "q ";
-            else if (chessboard.blackKing & mask)
-                std::cout << "k ";
-            else
+            // Find the piece on the square and print it, in upper case for white and lower case for black
+            PieceType piece = chessboard.pieceAt(static_cast<Square>(square));
+            if (piece == PieceType::None)
                 std::cout << ". ";
+            else
+                std::cout << ((chessboard.byColor[White] & mask) ? "PNBRQK" : "pnbrqk")[piece] << " ";
         }
         std::cout << std::endl;
     }
@@ -1,414 +1,369 @@
 #include "chessboard.h"
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 #include "board_visualization.h"
 #include "move.h"
+#include "stats.h"
+#include "trace.h"
 
 Chessboard::Chessboard() {
     // Initialize the bitboards to match the piece's positions at the start of the game
-    whitePawns = 0xFF00ULL;
-    whiteKnights = 0x42ULL;
-    whiteBishops = 0x24ULL;
-    whiteRooks = 0x81ULL;
-    whiteQueen = 0x10ULL;
-    whiteKing = 0x08ULL;
-    whitePieces = 0xFFFFULL;
-
-    blackPawns = 0xFF000000000000ULL;
-    blackKnights = 0x4200000000000000ULL;
-    blackBishops = 0x2400000000000000ULL;
-    blackRooks = 0x8100000000000000ULL;
-    blackQueen = 0x1000000000000000ULL;
-    blackKing = 0x0800000000000000ULL;
-    blackPieces = 0xFFFF000000000000ULL;
-
-    allPieces = whitePieces | blackPieces;
+    pieces[White][Pawn] = 0xFF00ULL;
+    pieces[White][Knight] = 0x42ULL;
+    pieces[White][Bishop] = 0x24ULL;
+    pieces[White][Rook] = 0x81ULL;
+    pieces[White][Queen] = 0x10ULL;
+    pieces[White][King] = 0x08ULL;
+    byColor[White] = 0xFFFFULL;
+
+    pieces[Black][Pawn] = 0xFF000000000000ULL;
+    pieces[Black][Knight] = 0x4200000000000000ULL;
+    pieces[Black][Bishop] = 0x2400000000000000ULL;
+    pieces[Black][Rook] = 0x8100000000000000ULL;
+    pieces[Black][Queen] = 0x1000000000000000ULL;
+    pieces[Black][King] = 0x0800000000000000ULL;
+    byColor[Black] = 0xFFFF000000000000ULL;
+
+    allPieces = byColor[White] | byColor[Black];
 
     turn = White;
 
-    // Negative value used to indicate no possible en passant moves as it does not correspond to any square index
-    Bitboard enPassant = 0ULL;
+    // An empty bitboard indicates that no en passant capture is possible
+    enPassant = 0ULL;
 
     // Players start out with all castling rights
     whiteQueenCastle = whiteKingCastle = blackQueenCastle = blackKingCastle = true;
-    whiteQueenCastleBeforeMove = whiteKingCastleBeforeMove = blackQueenCastleBeforeMove = blackKingCastleBeforeMove = true;
 
-    // Set attack table values
-    this->initializeLookupTables();
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    key = computeKey();
+    attackCache.valid = 0;
 }
 
-// Return the type of piece present at a given square
-PieceType Chessboard::pieceAt(Square square) {
-    if (GET_BIT(whitePawns, square) != 0 || GET_BIT(blackPawns, square) != 0) {
-        return PieceType::Pawn;
-    } else if (GET_BIT(whiteKnights, square) != 0 || GET_BIT(blackKnights, square) != 0) {
-        return PieceType::Knight;
-    } else if (GET_BIT(whiteBishops, square) != 0 || GET_BIT(blackBishops, square) != 0) {
-        return PieceType::Bishop;
-    } else if (GET_BIT(whiteRooks, square) != 0 || GET_BIT(blackRooks, square) != 0) {
-        return PieceType::Rook;
-    } else if (GET_BIT(whiteQueen, square) != 0 || GET_BIT(blackQueen, square) != 0) {
-        return PieceType::Queen;
-    } else if (GET_BIT(whiteKing, square) != 0 || GET_BIT(blackKing, square) != 0) {
-        return PieceType::King;
-    } else {
-        return PieceType::None;
+Chessboard::Chessboard(const Position &position) : Position(position) {
+    attackCache.valid = 0;
+}
+
+// Replace the current position with the one described by a FEN string, discarding the game history
+bool Chessboard::loadFEN(const std::string &fen) {
+    history.clear();
+    return Position::loadFEN(fen);
+}
+
+const GenerationMasks &Chessboard::attackInfo() const {
+    if (attackCache.key != key)
+        attackCache.valid = 0;
+    if (attackCache.valid & AttackCache::Masks) {
+        STATS_INC(StatCacheHits);
+        return attackCache.masks;
+    }
+    STATS_INC(StatCacheMisses);
+    attackCache.masks = legalMasks(*this);
+    attackCache.key = key;
+    attackCache.valid |= AttackCache::Masks;
+    return attackCache.masks;
+}
+
+const CheckInfo &Chessboard::checkInfo() const {
+    if (attackCache.key != key)
+        attackCache.valid = 0;
+    if (attackCache.valid & AttackCache::Checks) {
+        STATS_INC(StatCacheHits);
+        return attackCache.checks;
     }
+    STATS_INC(StatCacheMisses);
+    attackCache.checks = ::checkInfo(*this);
+    attackCache.key = key;
+    attackCache.valid |= AttackCache::Checks;
+    return attackCache.checks;
+}
+
+bool Chessboard::isPseudoLegal(Move move) const {
+    return (turn == White) ? ::isPseudoLegal<White>(*this, move) : ::isPseudoLegal<Black>(*this, move);
+}
+
+bool Chessboard::isLegal(Move move) const {
+    if (turn == White)
+        return ::isPseudoLegal<White>(*this, move) && ::isLegal<White>(*this, attackInfo(), move);
+    return ::isPseudoLegal<Black>(*this, move) && ::isLegal<Black>(*this, attackInfo(), move);
+}
+
+/*
+A move checks directly when the piece lands on one of its check squares, or by discovery when it uncovers one of our sliders.
+The rest need the board after the move: a promoted piece may attack through the square the pawn left,
+an en passant capture removes a second piece from the board, and castling checks with the rook.
+*/
+bool Chessboard::givesCheck(Move move) const {
+    if (!pieces[~turn][King])
+        return false;
+    const CheckInfo &info = this->checkInfo();
+    Square fromSquare = move.getFromSquare(), toSquare = move.getToSquare();
+    Bitboard from = BITBOARD(fromSquare), to = BITBOARD(toSquare), enemyKing = BITBOARD(info.enemyKing);
+    Move::MoveType moveType = move.getMoveType();
+    PieceType type = pieceAt(fromSquare);
+
+    if (!move.isPromotion() && type != King && (info.checkSquares[type] & to))
+        return true;
+    if ((info.discoverers & from) && !(lineSquares[fromSquare][info.enemyKing] & to))
+        return true;
+
+    const Bitboard *ourPieces = pieces[turn];
+    if (move.isPromotion()) {
+        Bitboard occupancy = (allPieces ^ from) | to;
+        switch (static_cast<PieceType>(PieceType::Knight + (moveType & 0x3))) {
+            case Knight: return knightAttacks[toSquare] & enemyKing;
+            case Bishop: return bishopAttacks(toSquare, occupancy) & enemyKing;
+            case Rook: return rookAttacks(toSquare, occupancy) & enemyKing;
+            default: return queenAttacks(toSquare, occupancy) & enemyKing;
+        }
+    }
+    if (moveType == Move::EnPassant) {
+        Bitboard occupancy = (allPieces ^ from ^ enPassant) | to;
+        return (rookAttacks(info.enemyKing, occupancy) & (ourPieces[Rook] | ourPieces[Queen])) ||
+               (bishopAttacks(info.enemyKing, occupancy) & (ourPieces[Bishop] | ourPieces[Queen]));
+    }
+    if (moveType == Move::KingCastle || moveType == Move::QueenCastle) {
+        bool kingSide = moveType == Move::KingCastle;
+        Square rookFrom = (turn == White) ? (kingSide ? Square::h1 : Square::a1) : (kingSide ? Square::h8 : Square::a8);
+        Square rookTo = (turn == White) ? (kingSide ? Square::f1 : Square::d1) : (kingSide ? Square::f8 : Square::d8);
+        Bitboard occupancy = allPieces ^ from ^ to ^ BITBOARD(rookFrom) ^ BITBOARD(rookTo);
+        return rookAttacks(rookTo, occupancy) & enemyKing;
+    }
+    return false;
 }
 
 // Check if a square is under attack by the enemy
 bool Chessboard::underAttack(Square square) {
-    // Generate the opponent's possible moves
-    this->passTurn();
-    MoveList enemyMoves = this->generateLegalMoves();
-    this->passTurn();
-
-    // The piece is under attack if one of the moves lands on the given square
-    for (int i = 0; i < enemyMoves.size(); i++)
-        if (enemyMoves[i].isCapture() && enemyMoves[i].getToSquare() == square)
-            return true;
-    return false;
+    return attackInfo().attacked & BITBOARD(square);
 }
 
 // Returns true if a king is under attack
 bool Chessboard::isCheck() {
-    return underAttack(static_cast<Square>(GET_LSB((turn == White) ? whiteKing : blackKing)));
+    return attackInfo().checkers;
+}
+
+// Everything but the legal move test, which the callers answer in their own way
+static GameStatus statusOf(Chessboard &chessboard, bool hasLegalMove) {
+    bool check = chessboard.isCheck();
+    if (!hasLegalMove) {
+        if (!check)
+            return GameStatus::Stalemate;
+        chessboard.winner = (chessboard.turn == White) ? Black : White;
+        return GameStatus::Checkmate;
+    }
+    if (chessboard.isThreefoldRepetition())
+        return GameStatus::Repetition;
+    if (chessboard.isFiftyMoveDraw())
+        return GameStatus::FiftyMoveRule;
+    if (chessboard.isInsufficientMaterial())
+        return GameStatus::InsufficientMaterial;
+    return check ? GameStatus::Check : GameStatus::Ongoing;
+}
+
+GameStatus Chessboard::gameStatus() {
+    return statusOf(*this, this->hasLegalMove());
+}
+
+GameStatus Chessboard::gameStatus(MoveList &legalMoves) {
+    legalMoves = this->generateLegalMoves();
+    return statusOf(*this, !legalMoves.empty());
 }
 
 // Check if a player has won and update winner if so
 bool Chessboard::isCheckmate() {
-    // Check if there is a move that gets the king out of check
-    MoveList legalMoves = this->generateLegalMoves();
-    for (int i = 0; i < legalMoves.size(); i++) {
-        this->push(legalMoves[i]);
-        if (!this->isCheck()) {
-            this->pop();
-            return false;
-        }
-        this->pop();
-    }
+    // Every legal move gets the king out of check, so it is mate exactly when there is none
+    if (!this->isCheck() || this->hasLegalMove())
+        return false;
     winner = (turn == White) ? Black : White;
     return true;
 }
 
-// Pass board control to the opponent
-void Chessboard::passTurn() {
-    turn = (turn == White) ? Black : White;
+// Check if the current player has no legal move but is not in check
+bool Chessboard::isStalemate() {
+    return !this->hasLegalMove() && !this->isCheck();
 }
 
-// Push a move onto the board
-void Chessboard::push(Move move) {
-    // Push the move to history
-    pastMoves.push_back(move);
-
-    // Get move information
-    Square fromSquare = move.getFromSquare(), toSquare = move.getToSquare();
-    Move::MoveType moveType = move.getMoveType();
-    PieceType fromPiece = pieceAt(fromSquare);
-    PieceType toPiece = (move.isCapture()) ? pieceAt(toSquare) : PieceType::None;
-
-    // Log castling information before move for future popping
-    whiteKingCastleBeforeMove = whiteKingCastle;
-    whiteQueenCastleBeforeMove = whiteQueenCastle;
-    blackKingCastleBeforeMove = blackKingCastle;
-    blackQueenCastleBeforeMove = blackQueenCastle;
-
-    // If a player's king moves from the starting position, disable castling for that player
-    if (fromPiece == PieceType::King) {
-        if (turn == White && fromSquare == Square::e1)
-            whiteKingCastle = whiteQueenCastle = false;
-        else if (turn == Black && fromSquare == Square::e8)
-            blackKingCastle = blackQueenCastle = false;
-    }
+/*
+Repetitions are found by comparing Zobrist keys.
+Captures and pawn moves can never be undone, so no position before the last of them can recur,
+and the halfmove clock says exactly how far back that was; only every other ply has the same side to move.
+*/
+int Chessboard::countRepetitions() const {
+    int plies = static_cast<int>(history.keys.size());
+    int distance = std::min<int>(halfmoveClock, plies);
+    int count = 0;
+    for (int ply = 4; ply <= distance; ply += 2)
+        count += history.keys[plies - ply] == key;
+    return count;
+}
 
-    // If a rook moves, disable castling for that corner
-    if (fromSquare == Square::h1)
-        whiteKingCastle = false;
-    if (fromSquare == Square::a1)
-        whiteQueenCastle = false;
-    if (fromSquare == Square::h8)
-        blackKingCastle = false;
-    if (fromSquare == Square::a8)
-        blackQueenCastle = false;
-
-    // Handle rook movement for castling
-    if (turn == White && moveType == Move::KingCastle) {
-        whiteKingCastle = whiteQueenCastle = false;
-        this->push(Move(Square::h1, Square::f1, Move::Quiet));
-        this->pop(); // Remove the extra move just logged as castling is recorded as one move
-    } else if (turn == White && moveType == Move::QueenCastle) {
-        whiteKingCastle = whiteQueenCastle = false;
-        this->push(Move(Square::a1, Square::d1, Move::Quiet));
-        this->pop();
-    } else if (turn == Black && moveType == Move::KingCastle) {
-        blackKingCastle = blackQueenCastle = false;
-        this->push(Move(Square::h8, Square::f8, Move::Quiet));
-        this->pop();
-    } else if (turn == Black && moveType == Move::QueenCastle) {
-        blackKingCastle = blackQueenCastle = false;
-        this->push(Move(Square::a8, Square::d8, Move::Quiet));
-        this->pop();
-    }
+bool Chessboard::isRepetition() const {
+    int plies = static_cast<int>(history.keys.size());
+    int distance = std::min<int>(halfmoveClock, plies);
+    for (int ply = 4; ply <= distance; ply += 2)
+        if (history.keys[plies - ply] == key)
+            return true;
+    return false;
+}
 
-    // Store en passant squares if necessary
-    if (moveType == Move::DoublePawnPush)
-        enPassant = move.getToSquare();
+bool Chessboard::isThreefoldRepetition() const {
+    return countRepetitions() >= 2;
+}
 
-    // Perform en passant pawn capture
-    if (moveType == Move::EnPassant) {
-        if (BITBOARD(toSquare) == northeast(BITBOARD(fromSquare)) || BITBOARD(toSquare) == northwest(BITBOARD(fromSquare))) {
-            Square captureSquare = static_cast<Square>(GET_LSB(south(BITBOARD(toSquare))));
-            CLEAR_BIT(blackPawns, captureSquare); // We know the captured pawn's color based on the direction it advances in
-        } else if (BITBOARD(toSquare) == southeast(BITBOARD(fromSquare)) || BITBOARD(toSquare) == southwest(BITBOARD(fromSquare))) {
-            Square captureSquare = static_cast<Square>(GET_LSB(north(BITBOARD(toSquare))));
-            CLEAR_BIT(whitePawns, captureSquare);
-        }
-        capturedPieces.push_back(PieceType::Pawn);
-    }
+// Checkmate on the hundredth ply takes precedence, so callers should test for it first
+bool Chessboard::isFiftyMoveDraw() const {
+    return halfmoveClock >= 100;
+}
 
-    // Move piece on its board
-    Bitboard *movingBoard;
-    switch (fromPiece) {
-        case PieceType::Pawn:
-            movingBoard = (turn == White) ? &whitePawns : &blackPawns;
-            break;
-        case PieceType::Knight:
-            movingBoard = (turn == White) ? &whiteKnights : &blackKnights;
-            break;
-        case PieceType::Bishop:
-            movingBoard = (turn == White) ? &whiteBishops : &blackBishops;
-            break;
-        case PieceType::Rook:
-            movingBoard = (turn == White) ? &whiteRooks : &blackRooks;
-            break;
-        case PieceType::Queen:
-            movingBoard = (turn == White) ? &whiteQueen : &blackQueen;
-            break;
-        case PieceType::King:
-            movingBoard = (turn == White) ? &whiteKing : &blackKing;
-            break;
-    }
+bool Chessboard::isInsufficientMaterial() const {
+    // Any pawn, rook or queen can still lead to mate
+    if (pieces[White][Pawn] | pieces[Black][Pawn] | pieces[White][Rook] | pieces[Black][Rook] | pieces[White][Queen] | pieces[Black][Queen])
+        return false;
 
-    CLEAR_BIT(*movingBoard, fromSquare);
-    SET_BIT(*movingBoard, toSquare);
-
-    // Erase pieces at capture positions
-    if (move.isCapture() && moveType != Move::EnPassant) {
-        Bitboard *captureBoard;
-        switch (toPiece) {
-            case PieceType::Pawn:
-                capturedPieces.push_back(PieceType::Pawn);
-                captureBoard = (turn == White) ? &blackPawns : &whitePawns;
-                break;
-            case PieceType::Knight:
-                capturedPieces.push_back(PieceType::Knight);
-                captureBoard = (turn == White) ? &blackKnights : &whiteKnights;
-                break;
-            case PieceType::Bishop:
-                capturedPieces.push_back(PieceType::Bishop);
-                captureBoard = (turn == White) ? &blackBishops : &whiteBishops;
-                break;
-            case PieceType::Rook:
-                capturedPieces.push_back(PieceType::Rook);
-                captureBoard = (turn == White) ? &blackRooks : &whiteRooks;
-                break;
-            case PieceType::Queen:
-                capturedPieces.push_back(PieceType::Queen);
-                captureBoard = (turn == White) ? &blackQueen : &whiteQueen;
-                break;
-            case PieceType::King:
-                capturedPieces.push_back(PieceType::King);
-                captureBoard = (turn == White) ? &blackKing : &whiteKing;
-                break;
-        }
+    // A lone minor piece cannot mate, and neither can any number of bishops that all stand on squares of one color
+    Bitboard knights = pieces[White][Knight] | pieces[Black][Knight];
+    Bitboard bishops = pieces[White][Bishop] | pieces[Black][Bishop];
+    return COUNT_BITS(knights | bishops) <= 1 || (!knights && (!(bishops & LIGHT_SQUARES) || !(bishops & DARK_SQUARES)));
+}
 
-        // Clear the piece and add it to captured piece history
-        CLEAR_BIT(*captureBoard, toSquare);\
-    
-    // Add blank captures to non capture moves to keep pastMoves and capturedPieces in sync
-    } else if (moveType != Move::EnPassant) {
-        capturedPieces.push_back(PieceType::None);
+// Find the legal move described by coordinate notation
+Move Chessboard::parseMove(const std::string &notation) {
+    if (notation.size() != 4 && notation.size() != 5)
+        return Move();
+
+    // Convert square names to indices, remembering that files are numbered from h to a
+    int squares[2];
+    for (int i = 0; i < 2; i++) {
+        char file = notation[i * 2], rank = notation[i * 2 + 1];
+        if (file < 'a' || file > 'h' || rank < '1' || rank > '8')
+            return Move();
+        squares[i] = (rank - '1') * 8 + ('h' - file);
     }
 
-    // Perform promotions
-    if (move.isPromotion()) {
-        Bitboard *promotionBoard;
-        switch (moveType) {
-            case Move::KnightPromotion:
-            case Move::KnightPromotionCapture:
-                promotionBoard = (turn == White) ? &whiteKnights : &blackKnights;
-                break;
-            case Move::BishopPromotion:
-            case Move::BishopPromotionCapture:
-                promotionBoard = (turn == White) ? &whiteBishops : &blackBishops;
-                break;
-            case Move::RookPromotion:
-            case Move::RookPromotionCapture:
-                promotionBoard = (turn == White) ? &whiteRooks : &blackRooks;
-                break;
-            case Move::QueenPromotion:
-            case Move::QueenPromotionCapture:
-                promotionBoard = (turn == White) ? &whiteQueen : &blackQueen;
-                break;
+    // Promotions are identified by a trailing piece letter
+    PieceType promotion = PieceType::None;
+    if (notation.size() == 5) {
+        switch (notation[4]) {
+            case 'n': promotion = PieceType::Knight; break;
+            case 'b': promotion = PieceType::Bishop; break;
+            case 'r': promotion = PieceType::Rook; break;
+            case 'q': promotion = PieceType::Queen; break;
+            default: return Move();
         }
-
-        CLEAR_BIT(*movingBoard, toSquare); // Remove temporary pawn move
-        SET_BIT(*promotionBoard, toSquare); // Set new piece type as present
     }
 
-    // Update cumulative bitboards
-    if (turn == White) {
-        CLEAR_BIT(whitePieces, fromSquare);
-        SET_BIT(whitePieces, toSquare);
-        if (move.isCapture())
-            CLEAR_BIT(blackPieces, toSquare);
-    } else {
-        CLEAR_BIT(blackPieces, fromSquare);
-        SET_BIT(blackPieces, toSquare);
-        if (move.isCapture())
-            CLEAR_BIT(whitePieces, toSquare);
-    }
-    allPieces = whitePieces | blackPieces;
-
-    // Transfer control of the board to the opponent
-    this->passTurn();
+    /*
+    Work out the move type from the pieces on the board, then check the move directly instead of generating every legal move.
+    A king moving two squares along its rank is castling, and a pawn moving diagonally onto an empty square captures en passant.
+    */
+    Square from = static_cast<Square>(squares[0]), to = static_cast<Square>(squares[1]);
+    PieceType piece = pieceAt(from);
+    bool capture = byColor[~turn] & BITBOARD(to);
+    int moveType = capture ? Move::Capture : Move::Quiet;
+    if (piece == King && (from - to == 2 || to - from == 2))
+        moveType = (to < from) ? Move::KingCastle : Move::QueenCastle;
+    else if (piece == Pawn && (from - to == 16 || to - from == 16))
+        moveType = Move::DoublePawnPush;
+    else if (piece == Pawn && (from - to) % 8 != 0 && !capture)
+        moveType = Move::EnPassant;
+    // The low two bits of a promotion's type select the piece, from knight to queen
+    if (promotion != PieceType::None)
+        moveType |= Move::KnightPromotion | (promotion - PieceType::Knight);
+
+    Move move(from, to, static_cast<Move::MoveType>(moveType));
+    return isLegal(move) ? move : Move();
 }
 
-// Take back the last move made
-void Chessboard::pop() {
-    // Get information about the last move
-    Move lastMove = pastMoves.back();
-    Square fromSquare = lastMove.getFromSquare(), toSquare = lastMove.getToSquare();
-    PieceType fromPiece = pieceAt(fromSquare), capturedPiece = capturedPieces.back();
-    Move::MoveType moveType = lastMove.getMoveType();
-
-    // Delete the move from history
-    pastMoves.pop_back();
-    capturedPieces.pop_back();
-
-    // Transfer control of the board back to the player who made the move being popped
-    this->passTurn();
-
-    // Move the piece back to its original position
-    Move undoMove = Move(toSquare, fromSquare, Move::Quiet); // To and from squares reversed
-    this->push(undoMove);
-    // Undo side effects of pushing the undo move
-    this->passTurn();
-    pastMoves.pop_back();
-    capturedPieces.pop_back();
-
-    // Undo promotions
-    if (lastMove.isPromotion()) {
-        // Determine piece type of the promoted pawn
-        PieceType promotedPiece;
-        switch (moveType) {
-            case Move::KnightPromotion:
-            case Move::KnightPromotionCapture:
-                promotedPiece = PieceType::Knight;
-                break;
-            case Move::BishopPromotion:
-            case Move::BishopPromotionCapture:
-                promotedPiece = PieceType::Bishop;
-                break;
-            case Move::RookPromotion:
-            case Move::RookPromotionCapture:
-                promotedPiece = PieceType::Rook;
-                break;
-            case Move::QueenPromotion:
-            case Move::QueenPromotionCapture:
-                promotedPiece = PieceType::Queen;
-                break;
+/*
+Standard algebraic notation names the moving piece and its destination, adding only as much of the origin square
+as is needed to tell it apart from another piece of the same type that could go to the same square.
+Pawn captures always give the origin file, and a check or mate found by playing the move is marked at the end.
+*/
+int Chessboard::formatSAN(Move move, char *buffer) {
+    Square fromSquare = move.getFromSquare(), toSquare = move.getToSquare();
+    Move::MoveType moveType = move.getMoveType();
+    PieceType type = pieceAt(fromSquare);
+    int length = 0;
+
+    auto append = [&](const char *text) {
+        while (*text)
+            buffer[length++] = *text++;
+    };
+
+    if (moveType == Move::KingCastle) {
+        append("O-O");
+    } else if (moveType == Move::QueenCastle) {
+        append("O-O-O");
+    } else {
+        if (type == PieceType::Pawn) {
+            if (move.isCapture())
+                buffer[length++] = Move::squareNames[fromSquare][0];
+        } else {
+            buffer[length++] = "PNBRQK"[type];
+
+            // Look for other pieces of the same type that can reach the destination
+            MoveList legalMoves = this->generateLegalMoves();
+            bool ambiguous = false, sameFile = false, sameRank = false;
+            for (Move other : legalMoves) {
+                Square otherSquare = other.getFromSquare();
+                if (other.getToSquare() != toSquare || otherSquare == fromSquare || pieceAt(otherSquare) != type)
+                    continue;
+                ambiguous = true;
+                sameFile |= otherSquare % 8 == fromSquare % 8;
+                sameRank |= otherSquare / 8 == fromSquare / 8;
+            }
+            // The file is preferred, then the rank, and both are given only when neither alone is unique
+            if (ambiguous && (!sameFile || sameRank))
+                buffer[length++] = Move::squareNames[fromSquare][0];
+            if (ambiguous && sameFile)
+                buffer[length++] = Move::squareNames[fromSquare][1];
         }
 
-        // Reset the promoted piece back to a pawn
-        Bitboard *promotionBoard;
-        switch (promotedPiece) {
-            case PieceType::Knight:
-                promotionBoard = (turn == White) ? &whiteKnights : &blackKnights;
-                break;
-            case PieceType::Bishop:
-                promotionBoard = (turn == White) ? &whiteBishops : &blackBishops;
-                break;
-            case PieceType::Rook:
-                promotionBoard = (turn == White) ? &whiteRooks : &blackRooks;
-                break;
-            case PieceType::Queen:
-                promotionBoard = (turn == White) ? &whiteQueen : &blackQueen;
-                break;
-        }
+        if (move.isCapture())
+            buffer[length++] = 'x';
+        append(Move::squareNames[toSquare]);
 
-        CLEAR_BIT(*promotionBoard, toSquare);
-        SET_BIT(*promotionBoard, fromSquare);
+        if (move.isPromotion()) {
+            buffer[length++] = '=';
+            buffer[length++] = "NBRQ"[moveType & 0x3];
+        }
     }
 
-    // Undo castling right loss
-    whiteKingCastle = whiteKingCastleBeforeMove;
-    whiteQueenCastle = whiteQueenCastleBeforeMove;
-    blackKingCastle = blackKingCastleBeforeMove;
-    blackQueenCastle = blackQueenCastleBeforeMove;
-
-    // Undo rook movement from castling
-    if (turn == White && moveType == Move::KingCastle) {
-        this->push(Move(Square::f1, Square::h1, Move::Quiet));
-        this->pop(); // Remove the extra move just logged as castling is recorded as one move
-    } else if (turn == White && moveType == Move::QueenCastle) {
-        this->push(Move(Square::d1, Square::a1, Move::Quiet));
-        this->pop();
-    } else if (turn == Black && moveType == Move::KingCastle) {
-        this->push(Move(Square::f8, Square::h8, Move::Quiet));
-        this->pop();
-    } else if (turn == Black && moveType == Move::QueenCastle) {
-        this->push(Move(Square::d8, Square::a8, Move::Quiet));
+    if (this->givesCheck(move)) {
+        this->push(move);
+        buffer[length++] = this->hasLegalMove() ? '+' : '#';
         this->pop();
     }
 
-    // Replace captured pieces
-    if (lastMove.isCapture() && moveType != Move::EnPassant) {
-        Bitboard *captureBoard;
-        switch (capturedPiece) {
-            case PieceType::None:
-                break;
-            case PieceType::Pawn:
-                captureBoard = (turn == White) ? &blackPawns : &whitePawns;
-                break;
-            case PieceType::Knight:
-                captureBoard = (turn == White) ? &blackKnights : &whiteKnights;
-                break;
-            case PieceType::Bishop:
-                captureBoard = (turn == White) ? &blackBishops : &whiteBishops;
-                break;
-            case PieceType::Rook:
-                captureBoard = (turn == White) ? &blackRooks : &whiteRooks;
-                break;
-            case PieceType::Queen:
-                captureBoard = (turn == White) ? &blackQueen : &whiteQueen;
-                break;
-            case PieceType::King:
-                captureBoard = (turn == White) ? &blackKing : &whiteKing;
-                break;
-        }
+    buffer[length] = '\0';
+    return length;
+}
 
-        // Clear the piece and add it to captured piece history
-        SET_BIT(*captureBoard, toSquare);
-    }
+// Push a move onto the board
+void Chessboard::push(Move move) {
+    STATS_INC(StatPushes);
+    TRACE_SCOPE("push");
 
-    // Restore pawns captured by en passant
-    if (moveType == Move::EnPassant) {
-        Bitboard *enPassantBoard = (turn == White) ? &whitePawns : &blackPawns; // Opposite of player who made the last move, as we are restoring the piece from 2 moves ago
-        SET_BIT(*enPassantBoard, POP_LSB(enPassant));
-        capturedPieces.pop_back();
-    }
+    // Push the move and the position it was played from to history
+    history.moves.push_back(move);
+    history.positions.push_back(*this);
+    history.keys.push_back(key);
+    history.attackCaches.push_back(attackCache);
 
-    // Update cumulative bitboards
-    if (turn == White) {
-        SET_BIT(whitePieces, fromSquare);
-        CLEAR_BIT(whitePieces, toSquare);
-        if (lastMove.isCapture())
-            SET_BIT(blackPieces, toSquare);
-    } else {
-        SET_BIT(blackPieces, fromSquare);
-        CLEAR_BIT(blackPieces, toSquare);
-        if (lastMove.isCapture())
-            SET_BIT(whitePieces, toSquare);
-    }
-    allPieces = whitePieces | blackPieces;
-}
\ No newline at end of file
+    makeMove(move);
+}
+
+// Take back the last move made
+void Chessboard::pop() {
+    STATS_INC(StatPops);
+    TRACE_SCOPE("pop");
+
+    // Restoring the saved position undoes every effect of the move at once
+    static_cast<Position &>(*this) = history.positions.back();
+    history.positions.pop_back();
+    history.keys.pop_back();
+    attackCache = history.attackCaches.back();
+    history.attackCaches.pop_back();
+    history.moves.pop_back();
+}
@@ -1,63 +1,90 @@
 #ifndef CHESSBOARD_H
 #define CHESSBOARD_H
 
+#include <vector>
 #include "bitboard.h"
 #include "move.h"
+#include "move_generation.h"
+#include "position.h"
 #include "types.h"
 
-struct Chessboard {
-    // Bitboards representing piece locations
-    Bitboard whitePawns;
-    Bitboard whiteKnights;
-    Bitboard whiteBishops;
-    Bitboard whiteRooks;
-    Bitboard whiteQueen;
-    Bitboard whiteKing;
-    Bitboard whitePieces;
-
-    Bitboard blackPawns;
-    Bitboard blackKnights;
-    Bitboard blackBishops;
-    Bitboard blackRooks;
-    Bitboard blackQueen;
-    Bitboard blackKing;
-    Bitboard blackPieces;
-
-    Bitboard allPieces;
-
-    // Active player
-    Color turn;
-
-    // Player who won
-    Color winner;
+/*
+Attack information about one position: enemy attacks, checkers, pins and the other legality masks, and what gives check.
+Each part is worked out on first use and tagged with the key of the position it describes,
+so any change to the position invalidates it, while pop brings back the copy saved for the earlier position.
+*/
+struct AttackCache {
+    enum Parts : uint8_t {
+        Masks = 1,
+        Checks = 2
+    };
+
+    GenerationMasks masks;
+    CheckInfo checks;
+    uint64_t key;
+    uint8_t valid; // Parts computed for the position with this key
+};
 
+// Record of how a game reached its current position, kept apart from the position itself
+struct GameHistory {
     // Tracks moves made so far
-    MoveList pastMoves;
+    MoveList moves;
+    // The position before each move in moves, restored when the move is popped
+    std::vector<Position> positions;
+    // Zobrist keys of the same positions, packed together so that repetition checks stay within a few cache lines
+    std::vector<uint64_t> keys;
+    // Attack caches of the same positions
+    std::vector<AttackCache> attackCaches;
+
+    void clear() {
+        moves.clear();
+        positions.clear();
+        keys.clear();
+        attackCaches.clear();
+    }
+};
 
-    // Variable to store double pawn moves that could enable an en passant
-    Bitboard enPassant;
+// Where the game stands for the side to move, from ongoing play to the ways it can end
+enum class GameStatus : uint8_t {
+    Ongoing,
+    Check, // Ongoing, with the side to move in check
+    Checkmate,
+    Stalemate,
+    Repetition, // Third occurrence of the position
+    FiftyMoveRule,
+    InsufficientMaterial
+};
 
-    // Used to track castling rights for each side
-    bool whiteQueenCastle, whiteKingCastle, blackQueenCastle, blackKingCastle;
+struct Chessboard : Position {
+    // Player who won
+    Color winner;
 
-    // Functions to keep track of the previous move's data for the pop function
-    bool whiteQueenCastleBeforeMove, whiteKingCastleBeforeMove, blackQueenCastleBeforeMove, blackKingCastleBeforeMove;
-    std::vector<PieceType> capturedPieces;
+    GameHistory history;
+    // Only a cache of facts about the position, so const queries may fill it in
+    mutable AttackCache attackCache;
 
     // Constructor for the start of the game
     Chessboard();
+    // Constructor continuing from an existing position, with no history
+    Chessboard(const Position &position);
+    // Set up the position described by a FEN string, returning false if it is malformed
+    bool loadFEN(const std::string &fen);
 
     // Move generation
     // Generate all legal moves for current player
     MoveList generateLegalMoves();
-    // Generate possible moves not considering check, ally piece placement, etc
+    // Generate possible moves not considering check
     MoveList generatePseudoLegalMoves();
-    // Generate initial values for attack tables
-    void initializeLookupTables();
+    // Count the legal moves without creating them
+    int countLegalMoves();
+    // Returns whether the current player has any legal move, stopping at the first one found
+    bool hasLegalMove();
 
     // Square info
-    // Returns the piece type at a given square
-    PieceType pieceAt(Square square);
+    // Returns the attack information of the current position, computing it on first use
+    const GenerationMasks &attackInfo() const;
+    // Returns the check squares and discovered check candidates of the current position, computing them on first use
+    const CheckInfo &checkInfo() const;
     // Returns whether or not a given square is under attack by the opponent
     bool underAttack(Square square);
 
@@ -66,13 +93,42 @@ struct Chessboard {
     void push(Move move);
     // Undo the last move made
     void pop();
-    // Give control of the board to the opponent
-    void passTurn();
+    // Returns the legal move matching coordinate notation such as "e2e4" or "e7e8q", or the null move if there is none
+    Move parseMove(const std::string &notation);
+    // Write a legal move in standard algebraic notation, such as Nbd7, exd8=Q or O-O#, returning its length
+    int formatSAN(Move move, char *buffer);
+
+    // Move info
+    // Returns whether a move, such as one from a hash table or a book, could be generated pseudo-legally in this position
+    bool isPseudoLegal(Move move) const;
+    // Returns whether a move is legal in this position, without generating any moves
+    bool isLegal(Move move) const;
+    // Returns whether a legal move would put the opponent in check, without playing it
+    bool givesCheck(Move move) const;
 
     // Endgame detection
+    /*
+    Work out check, mate, stalemate and draws by rule from one legality test, setting winner on checkmate.
+    Mate and stalemate take precedence over draws by rule. The second form also hands back the legal moves it generated,
+    so that a game loop can go on to pick one without generating them again.
+    */
+    GameStatus gameStatus();
+    GameStatus gameStatus(MoveList &legalMoves);
     bool isCheck();
     bool isCheckmate();
     bool isStalemate();
+
+    // Draw detection
+    // Number of times the current position occurred earlier in the game, with the same side to move
+    int countRepetitions() const;
+    // Returns whether the current position occurred before, which is enough for search to treat it as a draw
+    bool isRepetition() const;
+    // Returns whether the current position is on the board for the third time
+    bool isThreefoldRepetition() const;
+    // Returns whether fifty moves by each side passed without a capture or pawn move
+    bool isFiftyMoveDraw() const;
+    // Returns whether neither side has the material left to checkmate
+    bool isInsufficientMaterial() const;
 };
 
-#endif // CHESSBOARD_H
\ No newline at end of file
+#endif // CHESSBOARD_H
@@ -0,0 +1,134 @@
+#include "evaluation.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static const int phaseWeights[6] = { 0, 1, 1, 2, 4, 0 };
+static const char *phaseNames[2] = { "midgame", "endgame" };
+static const char *pieceNames[6] = { "pawn", "knight", "bishop", "rook", "queen", "king" };
+
+EvalParams evalParams = defaultEvalParams();
+
+EvalParams defaultEvalParams() {
+    static const int materialValues[2][6] = { { 100, 320, 330, 500, 900, 0 }, { 120, 300, 320, 540, 950, 0 } };
+    EvalParams params = {};
+    for (int phase = Midgame; phase <= Endgame; phase++)
+        for (int type = Pawn; type <= King; type++)
+            params.material[phase][type] = materialValues[phase][type];
+    return params;
+}
+
+int gamePhase(const Position &position) {
+    int phase = 0;
+    for (int type = Knight; type <= Queen; type++)
+        phase += phaseWeights[type] * COUNT_BITS(position.pieces[White][type] | position.pieces[Black][type]);
+    // Promotions can take the count past a full board
+    return (phase < MAX_PHASE) ? phase : MAX_PHASE;
+}
+
+int evaluate(const Position &position, const EvalParams &params) {
+    int scores[2] = { 0, 0 };
+    for (int color = White; color <= Black; color++) {
+        int sign = (color == White) ? 1 : -1;
+        // Mirroring the rank turns a black piece's square into the matching square for white
+        int mirror = (color == White) ? 0 : 56;
+        for (int type = Pawn; type <= King; type++) {
+            for (Bitboard pieces = position.pieces[color][type]; pieces;) {
+                int square = POP_LSB(pieces) ^ mirror;
+                for (int phase = Midgame; phase <= Endgame; phase++)
+                    scores[phase] += sign * (params.material[phase][type] + params.pieceSquare[phase][type][square]);
+            }
+        }
+    }
+    int phase = gamePhase(position);
+    int score = (scores[Midgame] * phase + scores[Endgame] * (MAX_PHASE - phase)) / MAX_PHASE;
+    return (position.turn == White) ? score : -score;
+}
+
+/*
+Each line holds one table: its name followed by its values, piece types in order for material
+and squares by index (h1 first) for piece-square tables. Blank lines and lines starting with # are skipped.
+*/
+bool loadEvalParams(const std::string &path, EvalParams &params) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Could not open evaluation parameters " << path << std::endl;
+        return false;
+    }
+
+    EvalParams loaded = {};
+    bool seen[2][7] = {};
+    std::string line, name;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream stream(line);
+        if (!(stream >> name) || name[0] == '#')
+            continue;
+
+        int *values = nullptr, count = 0;
+        for (int phase = Midgame; phase <= Endgame; phase++) {
+            if (name == std::string("material.") + phaseNames[phase]) {
+                values = loaded.material[phase], count = 6;
+                seen[phase][6] = true;
+            }
+            for (int type = Pawn; type <= King; type++) {
+                if (name == std::string("pieceSquare.") + phaseNames[phase] + "." + pieceNames[type]) {
+                    values = loaded.pieceSquare[phase][type], count = 64;
+                    seen[phase][type] = true;
+                }
+            }
+        }
+        int extra;
+        bool complete = values != nullptr;
+        for (int i = 0; complete && i < count; i++)
+            complete = static_cast<bool>(stream >> values[i]);
+        if (!complete || stream >> extra) {
+            std::cerr << path << ":" << lineNumber << ": malformed table " << name << std::endl;
+            return false;
+        }
+    }
+
+    for (int phase = Midgame; phase <= Endgame; phase++) {
+        for (int table = 0; table < 7; table++) {
+            if (!seen[phase][table]) {
+                std::cerr << path << " is missing the " << phaseNames[phase] << " " << ((table == 6) ? "material" : pieceNames[table]) << " table" << std::endl;
+                return false;
+            }
+        }
+    }
+    params = loaded;
+    return true;
+}
+
+bool saveEvalParams(const std::string &path, const EvalParams &params) {
+    std::FILE *output = path.empty() ? stdout : std::fopen(path.c_str(), "w");
+    if (!output) {
+        std::cerr << "Could not open evaluation parameters " << path << std::endl;
+        return false;
+    }
+
+    std::fprintf(output, "# Material by piece type, then piece-square tables by square index from h1 to a8 as seen by white\n");
+    for (int phase = Midgame; phase <= Endgame; phase++) {
+        std::fprintf(output, "material.%s", phaseNames[phase]);
+        for (int type = Pawn; type <= King; type++)
+            std::fprintf(output, " %d", params.material[phase][type]);
+        std::fprintf(output, "\n");
+    }
+    for (int phase = Midgame; phase <= Endgame; phase++) {
+        for (int type = Pawn; type <= King; type++) {
+            std::fprintf(output, "pieceSquare.%s.%s", phaseNames[phase], pieceNames[type]);
+            for (int square = 0; square < 64; square++)
+                std::fprintf(output, " %d", params.pieceSquare[phase][type][square]);
+            std::fprintf(output, "\n");
+        }
+    }
+
+    bool written = !std::ferror(output);
+    if (output != stdout)
+        written = (std::fclose(output) == 0) && written;
+    if (!written)
+        std::cerr << "Could not write evaluation parameters " << path << std::endl;
+    return written;
+}
@@ -0,0 +1,57 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <string>
+#include "position.h"
+#include "types.h"
+
+/*
+Static evaluation from material and piece-square tables, each with a middlegame and an endgame value.
+The two are blended by the game phase, worked out from the pieces left on the board, so that for example
+a king is pushed towards safety while queens are on and towards the centre once they are gone (a tapered evaluation).
+Every weight is stored in one flat block of integers, so that the tuner can treat them all alike and write them back out.
+More information can be found here:
+https://www.chessprogramming.org/Tapered_Eval
+*/
+
+enum EvalPhase {
+    Midgame,
+    Endgame
+};
+
+// Phase of a position with every piece on the board; each knight and bishop adds one, each rook two and each queen four
+const int MAX_PHASE = 24;
+
+struct EvalParams {
+    // Indexed by phase and then piece type
+    int material[2][6];
+    // Indexed by phase, piece type and square as seen by white; black pieces look up the square mirrored across the middle rank
+    int pieceSquare[2][6][64];
+
+    static const int COUNT = 2 * 6 + 2 * 6 * 64;
+
+    // Every weight in order, material first
+    int *values() { return &material[0][0]; }
+    const int *values() const { return &material[0][0]; }
+    static int materialIndex(int phase, int type) { return phase * 6 + type; }
+    static int pieceSquareIndex(int phase, int type, int square) { return 2 * 6 + (phase * 6 + type) * 64 + square; }
+};
+
+static_assert(sizeof(EvalParams) == EvalParams::COUNT * sizeof(int), "The tuner relies on the weights being contiguous");
+
+// Weights used by evaluate, starting out as the defaults
+extern EvalParams evalParams;
+
+// Usual material values and flat piece-square tables, a starting point for tuning
+EvalParams defaultEvalParams();
+// Returns the phase of a position, from MAX_PHASE with every piece on the board down to zero with only pawns and kings
+int gamePhase(const Position &position);
+// Returns the evaluation of a position in centipawns, from the point of view of the side to move
+int evaluate(const Position &position, const EvalParams &params = evalParams);
+
+// Read weights written by saveEvalParams, returning false if the file is missing or malformed
+bool loadEvalParams(const std::string &path, EvalParams &params);
+// Write weights as text, one table per line; an empty path writes to standard output
+bool saveEvalParams(const std::string &path, const EvalParams &params);
+
+#endif // EVALUATION_H
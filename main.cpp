@@ -5,13 +5,429 @@
 #include "board_visualization.h"
 #include "types.h"
 #include "chessboard.h"
+#include "analysis_cache.h"
+#include "match.h"
+#include "mate_solver.h"
+#include "mcts.h"
+#include "memory.h"
+#include "tuner.h"
+#include "position_index.h"
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <algorithm>
 
 // For random moves
 #include <cstdlib>
 #include <ctime>
 #include <random>
 
-int main() {
+// Parse the options of the match subcommand and run it
+int runMatchCommand(int argc, char *argv[]) {
+    MatchConfig config;
+    config.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 2; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", option.c_str());
+            return 1;
+        }
+        std::string value = argv[++i];
+        // Counts must be positive, and a value that is not a number at all is reported the same way
+        bool valid = true;
+        try {
+            if (option == "--games")
+                valid = (config.games = std::stoi(value)) >= 1;
+            else if (option == "--threads")
+                valid = (config.threads = std::stoi(value)) >= 1;
+            else if (option == "--seed")
+                config.seed = std::stoull(value);
+            else if (option == "--max-plies")
+                valid = (config.maxPlies = std::stoi(value)) >= 1;
+            else if (option == "--openings")
+                config.openingsFile = value;
+            else if (option == "--output")
+                config.outputFile = value;
+            else {
+                fprintf(stderr, "Unknown option %s\n", option.c_str());
+                return 1;
+            }
+        } catch (const std::invalid_argument &) {
+            valid = false;
+        } catch (const std::out_of_range &) {
+            valid = false;
+        }
+        if (!valid) {
+            fprintf(stderr, "Invalid value %s for %s\n", value.c_str(), option.c_str());
+            fprintf(stderr, "Usage: %s match [--games N] [--threads N] [--seed N] [--max-plies N] [--openings FILE] [--output FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    MatchSummary summary;
+    if (!runMatch(config, summary))
+        return 1;
+
+    // Statistics go to standard error so they never mix with records written to standard output
+    int games = summary.whiteWins + summary.blackWins + summary.draws;
+    fprintf(stderr, "Games: %d  White wins: %d (%.1f%%)  Black wins: %d (%.1f%%)  Draws: %d (%.1f%%)\n", games,
+            summary.whiteWins, 100.0 * summary.whiteWins / std::max(games, 1),
+            summary.blackWins, 100.0 * summary.blackWins / std::max(games, 1),
+            summary.draws, 100.0 * summary.draws / std::max(games, 1));
+    fprintf(stderr, "Time: %.2fs  Games per second: %.1f\n", summary.seconds, games / std::max(summary.seconds, 1e-9));
+    return 0;
+}
+
+// Build a position index from a corpus of games
+int runIndexCommand(int argc, char *argv[]) {
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s index CORPUS INDEX\n", argv[0]);
+        return 1;
+    }
+    return buildPositionIndex(argv[2], argv[3]) ? 0 : 1;
+}
+
+// Look up a position in an index, given as a FEN string or as the moves leading to it from the initial position
+int runQueryCommand(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s query INDEX [--fen FEN] [--moves MOVES] [--limit N]\n", argv[0]);
+        return 1;
+    }
+
+    Chessboard chessboard;
+    uint32_t limit = 20;
+    for (int i = 3; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", option.c_str());
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (option == "--fen") {
+            if (!chessboard.loadFEN(value)) {
+                fprintf(stderr, "Invalid FEN %s\n", value.c_str());
+                return 1;
+            }
+        } else if (option == "--moves") {
+            std::istringstream stream(value);
+            std::string notation;
+            while (stream >> notation) {
+                Move move = chessboard.parseMove(notation);
+                if (move.isNull()) {
+                    fprintf(stderr, "Illegal move %s\n", notation.c_str());
+                    return 1;
+                }
+                chessboard.push(move);
+            }
+        } else if (option == "--limit") {
+            limit = static_cast<uint32_t>(std::max(0, std::stoi(value)));
+        } else {
+            fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    PositionIndex index;
+    if (!index.open(argv[2]))
+        return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    const IndexEntry *entry = index.find(chessboard.key);
+    double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    if (entry && !index.inBounds(*entry)) {
+        fprintf(stderr, "%s is corrupt: the entry of this position points past the end of the file\n", argv[2]);
+        return 1;
+    }
+    for (uint32_t i = 0; entry && i < entry->moveCount; i++) {
+        if (!chessboard.isLegal(Move(index.movesOf(*entry)[i].move))) {
+            fprintf(stderr, "%s is corrupt: a move stored for this position is illegal\n", argv[2]);
+            return 1;
+        }
+    }
+
+    uint32_t games = entry ? entry->gameCount : 0;
+    printf("Games: %u of %llu\n", games, static_cast<unsigned long long>(index.gameCount()));
+    if (entry) {
+        const uint32_t *gameIds = index.gamesOf(*entry);
+        printf("Game ids:");
+        for (uint32_t i = 0; i < games && i < limit; i++)
+            printf(" %u", gameIds[i]);
+        printf((games > limit) ? " ...\n" : "\n");
+
+        // Moves are stored most frequent first
+        const IndexMoveStat *moves = index.movesOf(*entry);
+        uint32_t total = 0;
+        for (uint32_t i = 0; i < entry->moveCount; i++)
+            total += moves[i].count;
+        for (uint32_t i = 0; i < entry->moveCount; i++) {
+            char notation[Move::SAN_BUFFER_SIZE];
+            chessboard.formatSAN(Move(moves[i].move), notation);
+            printf("%-8s %8u %6.1f%%\n", notation, moves[i].count, 100.0 * moves[i].count / total);
+        }
+    }
+    fprintf(stderr, "Lookup: %.2f us over %llu positions\n", microseconds, static_cast<unsigned long long>(index.positionCount()));
+    return 0;
+}
+
+// Look for a forced mate by the side to move
+int runMateCommand(int argc, char *argv[]) {
+    Chessboard chessboard;
+    MateSearchLimits limits;
+    int tableMegabytes = 64;
+    std::string cachePath;
+    bool memoryReport = false;
+    for (int i = 2; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--checks-only" || option == "--shortest") {
+            (option == "--checks-only" ? limits.checksOnly : limits.shortest) = true;
+            continue;
+        }
+        if (option == "--memory") {
+            memoryReport = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", option.c_str());
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (option == "--fen") {
+            if (!chessboard.loadFEN(value)) {
+                fprintf(stderr, "Invalid FEN %s\n", value.c_str());
+                return 1;
+            }
+        } else if (option == "--max-moves") {
+            limits.maxMoves = std::max(1, std::stoi(value));
+        } else if (option == "--nodes") {
+            limits.maxNodes = std::stoull(value);
+        } else if (option == "--hash") {
+            tableMegabytes = std::max(1, std::stoi(value));
+        } else if (option == "--cache") {
+            cachePath = value;
+        } else {
+            fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    MateSolver solver(tableMegabytes);
+    AnalysisCache cache;
+    if (!cachePath.empty()) {
+        if (!cache.open(cachePath))
+            return 1;
+        solver.setAnalysisCache(&cache);
+    }
+    auto start = std::chrono::steady_clock::now();
+    MateSolution solution = solver.solve(chessboard, limits);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (solution.result == MateResult::Mate) {
+        printf("Mate in %d%s:", solution.mateIn, solution.shortest ? " (shortest)" : "");
+        for (size_t i = 0; i < solution.line.size(); i++) {
+            char notation[Move::SAN_BUFFER_SIZE];
+            chessboard.formatSAN(solution.line[i], notation);
+            chessboard.push(solution.line[i]);
+            printf(" %s", notation);
+        }
+        printf("\n");
+    } else if (solution.result == MateResult::NoMate) {
+        printf("No mate in %d\n", limits.maxMoves);
+    } else {
+        printf("Unknown: node limit reached\n");
+    }
+    fprintf(stderr, "Nodes: %llu  Time: %.2fs  Nodes per second: %.0f\n", static_cast<unsigned long long>(solution.nodes), seconds,
+            solution.nodes / std::max(seconds, 1e-9));
+    if (memoryReport)
+        printMemoryReport(stderr);
+    return 0;
+}
+
+// Run a Monte Carlo tree search on a position and print the moves it prefers
+int runMctsCommand(int argc, char *argv[]) {
+    Chessboard chessboard;
+    MctsLimits limits;
+    limits.threads = std::max(1u, std::thread::hardware_concurrency());
+    bool playoutsGiven = false;
+    int arenaMegabytes = 256;
+    bool memoryReport = false;
+    for (int i = 2; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--memory") {
+            memoryReport = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", option.c_str());
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (option == "--fen") {
+            if (!chessboard.loadFEN(value)) {
+                fprintf(stderr, "Invalid FEN %s\n", value.c_str());
+                return 1;
+            }
+        } else if (option == "--playouts") {
+            limits.maxPlayouts = std::stoull(value);
+            playoutsGiven = true;
+        } else if (option == "--time") {
+            limits.maxMilliseconds = std::max(1, std::stoi(value));
+        } else if (option == "--threads") {
+            limits.threads = std::max(1, std::stoi(value));
+        } else if (option == "--seed") {
+            limits.seed = std::stoull(value);
+        } else if (option == "--hash") {
+            arenaMegabytes = std::max(1, std::stoi(value));
+        } else if (option == "--exploration") {
+            limits.exploration = std::stod(value);
+        } else {
+            fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+    // A time limit alone searches for the whole time
+    if (limits.maxMilliseconds && !playoutsGiven)
+        limits.maxPlayouts = UINT64_MAX;
+
+    MctsSearch search(arenaMegabytes);
+    MctsResult result = search.search(chessboard, limits);
+    // A finished game is reported the way the interactive game ends, along with the rule that drew it
+    if (result.bestMove.isNull()) {
+        if (result.status == GameStatus::Checkmate)
+            printf("WINNER: %d\n", static_cast<int>(~chessboard.turn));
+        else if (result.status == GameStatus::Stalemate)
+            printf("STALEMATE\n");
+        else if (result.status == GameStatus::Repetition)
+            printf("DRAW: repetition\n");
+        else if (result.status == GameStatus::FiftyMoveRule)
+            printf("DRAW: fifty-move rule\n");
+        else if (result.status == GameStatus::InsufficientMaterial)
+            printf("DRAW: insufficient material\n");
+        else
+            printf("No move searched\n");
+        if (memoryReport)
+            printMemoryReport(stderr);
+        return 0;
+    }
+
+    char notation[Move::SAN_BUFFER_SIZE];
+    for (size_t i = 0; i < result.rootMoves.size() && i < 5; i++) {
+        chessboard.formatSAN(result.rootMoves[i].move, notation);
+        printf("%-8s visits %-10u score %.3f\n", notation, result.rootMoves[i].visits, result.rootMoves[i].score);
+    }
+    printf("Line:");
+    for (size_t i = 0; i < result.line.size(); i++) {
+        chessboard.formatSAN(result.line[i], notation);
+        chessboard.push(result.line[i]);
+        printf(" %s", notation);
+    }
+    printf("\n");
+    fprintf(stderr, "Playouts: %llu  Nodes: %llu  Time: %.2fs  Playouts per second: %.0f\n", static_cast<unsigned long long>(result.playouts),
+            static_cast<unsigned long long>(result.nodes), result.seconds, result.playouts / std::max(result.seconds, 1e-9));
+    if (memoryReport)
+        printMemoryReport(stderr);
+    return 0;
+}
+
+// Tune the evaluation weights against labeled positions
+int runTuneCommand(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s tune DATA [--epochs N] [--threads N] [--rate X] [--scaling X] [--params FILE] [--output FILE] [--memory]\n", argv[0]);
+        return 1;
+    }
+    TuneConfig config;
+    bool memoryReport = false;
+    config.dataFile = argv[2];
+    config.threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 3; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--memory") {
+            memoryReport = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", option.c_str());
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (option == "--epochs")
+            config.epochs = std::max(1, std::stoi(value));
+        else if (option == "--threads")
+            config.threads = std::max(1, std::stoi(value));
+        else if (option == "--rate")
+            config.learningRate = std::stod(value);
+        else if (option == "--scaling")
+            config.scaling = std::stod(value);
+        else if (option == "--params")
+            config.paramsFile = value;
+        else if (option == "--output")
+            config.outputFile = value;
+        else {
+            fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+    bool tuned = runTuner(config);
+    // The tuner has freed its arenas by now, so they show up in the peak column
+    if (memoryReport)
+        printMemoryReport(stderr);
+    return tuned ? 0 : 1;
+}
+
+// Maintain a persistent analysis cache
+int runCacheCommand(int argc, char *argv[]) {
+    if (argc < 4 || (std::strcmp(argv[2], "info") != 0 && std::strcmp(argv[2], "compact") != 0)) {
+        fprintf(stderr, "Usage: %s cache info FILE | %s cache compact FILE [--size MB]\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    if (std::strcmp(argv[2], "compact") == 0) {
+        size_t megabytes = 0;
+        if (argc == 6 && std::strcmp(argv[4], "--size") == 0) {
+            megabytes = std::max(1, std::stoi(argv[5]));
+        } else if (argc != 4) {
+            fprintf(stderr, "Usage: %s cache compact FILE [--size MB]\n", argv[0]);
+            return 1;
+        }
+        if (!compactAnalysisCache(argv[3], megabytes))
+            return 1;
+    }
+
+    AnalysisCache cache;
+    if (!cache.open(argv[3], 0, true))
+        return 1;
+    uint64_t entries = cache.countEntries();
+    printf("Entries: %llu of %llu (%.1f%%)\n", static_cast<unsigned long long>(entries), static_cast<unsigned long long>(cache.capacity()),
+           100.0 * entries / cache.capacity());
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    // Headless self-play: chess match [--games N] [--threads N] [--seed N] [--max-plies N] [--openings FILE] [--output FILE]
+    if (argc > 1 && std::strcmp(argv[1], "match") == 0)
+        return runMatchCommand(argc, argv);
+    // Position index over a corpus: chess index CORPUS INDEX, then chess query INDEX [--fen FEN] [--moves MOVES] [--limit N]
+    if (argc > 1 && std::strcmp(argv[1], "index") == 0)
+        return runIndexCommand(argc, argv);
+    if (argc > 1 && std::strcmp(argv[1], "query") == 0)
+        return runQueryCommand(argc, argv);
+    // Mate solver: chess mate --fen FEN [--max-moves N] [--nodes N] [--hash MB] [--cache FILE] [--checks-only] [--shortest] [--memory]
+    if (argc > 1 && std::strcmp(argv[1], "mate") == 0)
+        return runMateCommand(argc, argv);
+    // Monte Carlo tree search: chess mcts [--fen FEN] [--playouts N] [--time MS] [--threads N] [--seed N] [--hash MB] [--exploration C] [--memory]
+    if (argc > 1 && std::strcmp(argv[1], "mcts") == 0)
+        return runMctsCommand(argc, argv);
+    // Evaluation tuning: chess tune DATA [--epochs N] [--threads N] [--rate X] [--scaling X] [--params FILE] [--output FILE] [--memory]
+    if (argc > 1 && std::strcmp(argv[1], "tune") == 0)
+        return runTuneCommand(argc, argv);
+    // Analysis cache upkeep: chess cache info FILE, or chess cache compact FILE [--size MB]
+    if (argc > 1 && std::strcmp(argv[1], "cache") == 0)
+        return runCacheCommand(argc, argv);
+
     Chessboard chessboard;
     MoveList legalMoves;
     std::srand(static_cast<unsigned int>(std::time(nullptr)));
@@ -19,18 +435,21 @@ int main() {
 
     printChessboard(chessboard);
     while (true) {
-        if (chessboard.isCheckmate()) {
+        GameStatus status = chessboard.gameStatus(legalMoves);
+        Move bestMove;
+
+        if (status == GameStatus::Checkmate) {
             printf("WINNER: %d\n", chessboard.winner);
             break;
         }
-
-        legalMoves = chessboard.generateLegalMoves();
-        Move bestMove;
-
-        if (legalMoves.empty()) {
+        if (status == GameStatus::Stalemate) {
             printf("STALEMATE");
             break;
         }
+        if (status != GameStatus::Ongoing && status != GameStatus::Check) {
+            printf("DRAW");
+            break;
+        }
 
         int rand = std::rand() % legalMoves.size();
         bestMove = legalMoves[rand];
@@ -41,9 +460,10 @@ int main() {
                 bestMove = move;
         }
 
+        char notation[Move::SAN_BUFFER_SIZE];
+        chessboard.formatSAN(bestMove, notation);
         chessboard.push(bestMove);
-        printf("%d: ", moves+1);
-        bestMove.printMove();
+        printf("%d: %s\n", moves+1, notation);
         printChessboard(chessboard);
         moves++;
     }
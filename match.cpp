@@ -0,0 +1,159 @@
+#include "match.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "chessboard.h"
+#include "move.h"
+#include "prng.h"
+
+// Names used in game records, indexed by the enum values
+static const char *resultNames[] = { "1-0", "0-1", "1/2-1/2" };
+static const char *terminationNames[] = { "checkmate", "stalemate", "ply-limit", "repetition", "fifty-move-rule", "insufficient-material" };
+
+bool loadOpenings(const std::string &path, std::vector<std::vector<std::string>> &openings) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Could not open openings file " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        // Skip blank lines and comments
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+
+        // Replay the opening once up front so that games never start from a broken line
+        std::istringstream stream(line);
+        std::vector<std::string> opening;
+        std::string notation;
+        Chessboard chessboard;
+        while (stream >> notation) {
+            Move move = chessboard.parseMove(notation);
+            if (move.isNull()) {
+                std::cerr << path << ":" << lineNumber << ": illegal move " << notation << std::endl;
+                return false;
+            }
+            chessboard.push(move);
+            opening.push_back(notation);
+        }
+        openings.push_back(opening);
+    }
+
+    if (openings.empty()) {
+        std::cerr << "No openings found in " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Same policy as the interactive game: a random legal move, overridden by any available capture
+static Move selectMove(MoveList &legalMoves, PRNG &prng) {
+    Move bestMove = legalMoves[prng.nextBelow(legalMoves.size())];
+    for (size_t i = 0; i < legalMoves.size(); i++)
+        if (legalMoves[i].isCapture())
+            bestMove = legalMoves[i];
+    return bestMove;
+}
+
+// Play a single game to completion without any console output
+static GameRecord playGame(uint32_t game, uint32_t opening, const std::vector<std::string> &openingMoves, int maxPlies, PRNG &prng) {
+    GameRecord record = { game, opening, 0, GameResult::Draw, Termination::PlyLimit };
+    Chessboard chessboard;
+
+    for (size_t i = 0; i < openingMoves.size(); i++) {
+        chessboard.push(chessboard.parseMove(openingMoves[i]));
+        record.plies++;
+    }
+
+    while (record.plies < maxPlies) {
+        MoveList legalMoves;
+        GameStatus status = chessboard.gameStatus(legalMoves);
+        if (status == GameStatus::Checkmate) {
+            record.result = (chessboard.winner == White) ? GameResult::WhiteWin : GameResult::BlackWin;
+            record.termination = Termination::Checkmate;
+            break;
+        }
+        if (status != GameStatus::Ongoing && status != GameStatus::Check) {
+            record.result = GameResult::Draw;
+            record.termination = (status == GameStatus::Stalemate) ? Termination::Stalemate :
+                                 (status == GameStatus::Repetition) ? Termination::Repetition :
+                                 (status == GameStatus::FiftyMoveRule) ? Termination::FiftyMoveRule : Termination::InsufficientMaterial;
+            break;
+        }
+
+        chessboard.push(selectMove(legalMoves, prng));
+        record.plies++;
+    }
+
+    return record;
+}
+
+bool runMatch(const MatchConfig &config, MatchSummary &summary) {
+    if (config.games < 1 || config.threads < 1 || config.maxPlies < 1) {
+        std::cerr << "Games, threads and the ply limit must all be at least one" << std::endl;
+        return false;
+    }
+
+    std::vector<std::vector<std::string>> openings;
+    if (!config.openingsFile.empty()) {
+        if (!loadOpenings(config.openingsFile, openings))
+            return false;
+    } else {
+        openings.push_back(std::vector<std::string>());
+    }
+
+    std::FILE *output = stdout;
+    if (!config.outputFile.empty()) {
+        output = std::fopen(config.outputFile.c_str(), "w");
+        if (!output) {
+            std::cerr << "Could not open output file " << config.outputFile << std::endl;
+            return false;
+        }
+    }
+
+    // Every worker writes only to the records of the games it claims, so no locking is needed
+    std::vector<GameRecord> records(config.games);
+    std::atomic<int> nextGame(0);
+    auto worker = [&]() {
+        int game;
+        while ((game = nextGame.fetch_add(1, std::memory_order_relaxed)) < config.games) {
+            // Seeding per game rather than per thread keeps results independent of the thread count
+            PRNG prng(config.seed ^ (static_cast<uint64_t>(game) * 0x9E3779B97F4A7C15ULL));
+            uint32_t opening = game % openings.size();
+            records[game] = playGame(game, opening, openings[opening], config.maxPlies, prng);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 1; i < config.threads; i++)
+        threads.emplace_back(worker);
+    worker();
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Write one line per game: game number, opening index, result, length in plies and termination
+    for (size_t i = 0; i < records.size(); i++) {
+        const GameRecord &record = records[i];
+        std::fprintf(output, "%u %u %s %u %s\n", record.game, record.opening, resultNames[static_cast<int>(record.result)],
+                     record.plies, terminationNames[static_cast<int>(record.termination)]);
+        switch (record.result) {
+            case GameResult::WhiteWin: summary.whiteWins++; break;
+            case GameResult::BlackWin: summary.blackWins++; break;
+            case GameResult::Draw: summary.draws++; break;
+        }
+    }
+
+    if (output != stdout)
+        std::fclose(output);
+    return true;
+}
@@ -0,0 +1,63 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Headless self-play match runner.
+Games are distributed across worker threads, each game owning its own board and a seeded PRNG.
+Nothing is printed while games are in progress; one compact record per game is written once the match is over.
+*/
+
+// Settings for a self-play match
+struct MatchConfig {
+    int games = 1000;
+    int threads = 1;
+    int maxPlies = 512; // Games reaching this length are adjudicated as draws
+    uint64_t seed = 1;
+    std::string openingsFile; // One opening per line in coordinate notation, e.g. "e2e4 e7e5"; empty to start from the initial position
+    std::string outputFile; // Game records are written to standard output when empty
+};
+
+// Final outcome of a game from white's point of view
+enum class GameResult : uint8_t {
+    WhiteWin,
+    BlackWin,
+    Draw
+};
+
+// How a game came to an end
+enum class Termination : uint8_t {
+    Checkmate,
+    Stalemate,
+    PlyLimit,
+    Repetition,
+    FiftyMoveRule,
+    InsufficientMaterial
+};
+
+// Compact summary of a single finished game
+struct GameRecord {
+    uint32_t game;
+    uint32_t opening;
+    uint16_t plies;
+    GameResult result;
+    Termination termination;
+};
+
+// Aggregate statistics over a finished match
+struct MatchSummary {
+    int whiteWins = 0;
+    int blackWins = 0;
+    int draws = 0;
+    double seconds = 0;
+};
+
+// Read openings from a file, returning false if it cannot be read or contains an illegal move
+bool loadOpenings(const std::string &path, std::vector<std::vector<std::string>> &openings);
+// Play every game of the match and write out the records, returning false for a non-positive count or an unwritable file
+bool runMatch(const MatchConfig &config, MatchSummary &summary);
+
+#endif // MATCH_H
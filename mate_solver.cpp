@@ -0,0 +1,321 @@
+#include "mate_solver.h"
+#include <algorithm>
+#include <cstdlib>
+#include "stats.h"
+
+// Stands for an infinite proof or disproof number, which only a settled position has
+static const uint32_t INFINITE_NUMBER = 1u << 30;
+
+// Sums of finite numbers are clamped just below infinity, so that a large sum is never taken for a settled position
+static uint32_t addNumbers(uint32_t a, uint32_t b) {
+    return (a >= INFINITE_NUMBER || b >= INFINITE_NUMBER) ? INFINITE_NUMBER : std::min(a + b, INFINITE_NUMBER - 1);
+}
+
+MateSolver::MateSolver(size_t tableMegabytes) {
+    size_t entries = 2;
+    while (entries * 2 * sizeof(MateEntry) <= tableMegabytes * 1024 * 1024)
+        entries *= 2;
+    table.allocate(entries, MemoryMateSolver);
+}
+
+/*
+A position is stored separately for every number of plies left. Sharing one entry between depths let a shallow search
+overwrite the numbers of a deeper one still in progress, which then restarted from scratch and could keep the two
+alternating until the node limit. The plies left are mixed into the key, and checked again on lookup against collisions.
+*/
+static uint64_t tableKey(uint64_t key, int remaining) {
+    return key ^ (static_cast<uint64_t>(remaining + 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+// Positions not in the table start out with proof and disproof numbers of one
+MateSolver::NodeValue MateSolver::lookup(uint64_t key, int remaining) const {
+    key = tableKey(key, remaining);
+    size_t bucket = key & (table.size() - 2);
+    for (size_t i = bucket; i < bucket + 2; i++) {
+        const MateEntry &entry = table[i];
+        if (entry.key != key || entry.generation != generation || entry.remaining != remaining)
+            continue;
+        if (entry.proof == 0)
+            return { 0, INFINITE_NUMBER, entry.distance };
+        if (entry.disproof == 0)
+            return { INFINITE_NUMBER, 0, 0 };
+        return { entry.proof, entry.disproof, 0 };
+    }
+    return { 1, 1, 0 };
+}
+
+/*
+Each key has a bucket of two entries; a new position replaces whichever of them took less work to compute,
+where entries left over from earlier solves go first.
+*/
+void MateSolver::store(uint64_t key, const NodeValue &value, int remaining, uint64_t work) {
+    key = tableKey(key, remaining);
+    size_t bucket = key & (table.size() - 2);
+    MateEntry *entry = &table[bucket], *other = &table[bucket + 1];
+    int64_t entryWork = (entry->generation == generation) ? entry->work : -1;
+    int64_t otherWork = (other->generation == generation) ? other->work : -1;
+    bool entryMatches = entry->key == key && entryWork >= 0;
+    if ((other->key == key && otherWork >= 0) || (!entryMatches && otherWork < entryWork))
+        entry = other;
+    *entry = { key, value.proof, value.disproof, static_cast<uint32_t>(std::min<uint64_t>(work, 0xFFFFFF)), generation, value.distance,
+               static_cast<int16_t>(remaining) };
+}
+
+MoveList MateSolver::candidateMoves(Chessboard &board, bool attacker) {
+    MoveList moves = board.generateLegalMoves();
+    if (attacker && limits.checksOnly) {
+        moves.erase(std::remove_if(moves.begin(), moves.end(), [&board](Move move) { return !board.givesCheck(move); }), moves.end());
+    }
+    return moves;
+}
+
+// Numbers of the position after a move, where returning to an earlier position of the game fails to mate
+MateSolver::NodeValue MateSolver::childValue(Chessboard &board, Move move, int remaining) {
+    board.push(move);
+    NodeValue value = board.isRepetition() ? NodeValue{ INFINITE_NUMBER, 0, 0 } : lookup(board.key, remaining);
+    board.pop();
+    return value;
+}
+
+/*
+Search below a position until its proof number reaches proofThreshold or its disproof number reaches disproofThreshold.
+The attacker moves at even plies. Each round descends into the most promising move, the one with the smallest proof number
+for the attacker or the smallest disproof number for the defender, with thresholds that send the search back up
+as soon as another move becomes the better choice.
+*/
+void MateSolver::search(Chessboard &board, int ply, uint32_t proofThreshold, uint32_t disproofThreshold) {
+    nodes++;
+    uint64_t startNodes = nodes;
+    int remaining = 2 * limits.maxMoves - 1 - ply;
+    bool attacker = ply % 2 == 0;
+    MoveList moves = candidateMoves(board, attacker);
+
+    if (!attacker && moves.empty() && board.isCheck()) {
+        store(board.key, { 0, INFINITE_NUMBER, 0 }, remaining, 1);
+        return;
+    }
+    if (moves.empty() || remaining <= 0) {
+        store(board.key, { INFINITE_NUMBER, 0, 0 }, remaining, 1);
+        return;
+    }
+
+    std::vector<NodeValue> children(moves.size());
+    for (size_t i = 0; i < moves.size(); i++)
+        children[i] = childValue(board, moves[i], remaining - 1);
+
+    NodeValue node;
+    while (true) {
+        // Combine the numbers of the moves, keeping the shortest mate for the attacker and the longest for the defender
+        node = attacker ? NodeValue{ INFINITE_NUMBER, 0, UINT16_MAX } : NodeValue{ 0, INFINITE_NUMBER, 0 };
+        size_t best = 0;
+        uint32_t secondBest = INFINITE_NUMBER;
+        for (size_t i = 0; i < children.size(); i++) {
+            const NodeValue &child = children[i];
+            uint32_t number = attacker ? child.proof : child.disproof;
+            uint32_t bestNumber = attacker ? children[best].proof : children[best].disproof;
+            if (i > 0 && number < bestNumber) {
+                secondBest = bestNumber;
+                best = i;
+            } else if (i > 0) {
+                secondBest = std::min(secondBest, number);
+            }
+
+            if (attacker) {
+                node.proof = std::min(node.proof, child.proof);
+                node.disproof = addNumbers(node.disproof, child.disproof);
+                if (child.proof == 0)
+                    node.distance = std::min<uint16_t>(node.distance, child.distance + 1);
+            } else {
+                node.proof = addNumbers(node.proof, child.proof);
+                node.disproof = std::min(node.disproof, child.disproof);
+                node.distance = std::max<uint16_t>(node.distance, child.distance + 1);
+            }
+        }
+        if (node.proof >= proofThreshold || node.disproof >= disproofThreshold || nodes >= limits.maxNodes) {
+            if (node.proof && node.disproof && nodes < limits.maxNodes)
+                STATS_INC(StatCutoffs);
+            break;
+        }
+
+        uint32_t childProofThreshold, childDisproofThreshold;
+        if (attacker) {
+            childProofThreshold = std::min(proofThreshold, secondBest + 1);
+            childDisproofThreshold = disproofThreshold - node.disproof + children[best].disproof;
+        } else {
+            childProofThreshold = proofThreshold - node.proof + children[best].proof;
+            childDisproofThreshold = std::min(disproofThreshold, secondBest + 1);
+        }
+
+        board.push(moves[best]);
+        search(board, ply + 1, childProofThreshold, childDisproofThreshold);
+        board.pop();
+        children[best] = childValue(board, moves[best], remaining - 1);
+    }
+
+    store(board.key, node, remaining, nodes - startNodes + 1);
+}
+
+/*
+Follow the proof from the root: the attacker plays the move with the shortest mate and the defender the reply
+that holds out longest. Positions pushed out of the table along the way are searched again.
+*/
+void MateSolver::extractLine(Chessboard &board, MateSolution &solution) {
+    for (int ply = 0;; ply++) {
+        bool attacker = ply % 2 == 0;
+        int remaining = 2 * limits.maxMoves - 1 - ply;
+        MoveList moves = candidateMoves(board, attacker);
+        if (moves.empty())
+            break;
+
+        int best = -1;
+        uint16_t bestDistance = 0;
+        for (int attempt = 0; attempt < 2 && best < 0; attempt++) {
+            if (attempt) {
+                // Each search again gets the full node budget on top of what was spent so far
+                uint64_t maxNodes = limits.maxNodes;
+                limits.maxNodes = nodes + maxNodes;
+                search(board, ply, INFINITE_NUMBER, INFINITE_NUMBER);
+                limits.maxNodes = maxNodes;
+            }
+            for (size_t i = 0; i < moves.size(); i++) {
+                NodeValue child = childValue(board, moves[i], remaining - 1);
+                if (child.proof == 0 && (best < 0 || (attacker ? child.distance < bestDistance : child.distance > bestDistance))) {
+                    best = static_cast<int>(i);
+                    bestDistance = child.distance;
+                }
+            }
+        }
+        if (best < 0)
+            break;
+
+        board.push(moves[best]);
+        solution.line.push_back(moves[best]);
+    }
+
+    for (size_t i = 0; i < solution.line.size(); i++)
+        board.pop();
+}
+
+/*
+A cached mate answers the search when it is short enough, and known to be the shortest if that is asked for;
+its line is rebuilt by following the best moves recorded for the positions along it.
+A cached lack of mate answers any search it is at least as deep as.
+*/
+bool MateSolver::solveFromCache(Chessboard &board, MateSolution &solution) {
+    AnalysisRecord record;
+    if (!analysisCache || !analysisCache->probe(board.key, record))
+        return false;
+    if (record.kind == AnalysisNoMate || (record.kind == AnalysisShortestMate && record.score > limits.maxMoves)) {
+        if (record.kind == AnalysisNoMate && record.depth < limits.maxMoves)
+            return false;
+        solution.result = MateResult::NoMate;
+        return true;
+    }
+    if (record.score <= 0 || record.score > limits.maxMoves || (limits.shortest && record.kind != AnalysisShortestMate))
+        return false;
+
+    // Every move is checked for legality, so that a stale or colliding entry can never produce a broken line
+    std::vector<Move> line;
+    while (static_cast<int>(line.size()) < 2 * record.score - 1) {
+        AnalysisRecord step;
+        if (!analysisCache->probe(board.key, step) || step.kind == AnalysisNoMate)
+            break;
+        if (!board.isLegal(step.bestMove))
+            break;
+        board.push(step.bestMove);
+        line.push_back(step.bestMove);
+    }
+    bool mate = static_cast<int>(line.size()) == 2 * record.score - 1 && board.isCheck() && !board.hasLegalMove();
+    for (size_t i = 0; i < line.size(); i++)
+        board.pop();
+    if (!mate)
+        return false;
+
+    solution.result = MateResult::Mate;
+    solution.mateIn = record.score;
+    solution.shortest = record.kind == AnalysisShortestMate;
+    solution.line = line;
+    return true;
+}
+
+/*
+Record a mate for every position along its line, from the side to move's point of view, so that the line can be rebuilt.
+A mate never replaces a shorter one or a shortest one. A lack of mate is only recorded when every move was tried.
+*/
+void MateSolver::recordSolution(Chessboard &board, const MateSolution &solution) {
+    if (!analysisCache)
+        return;
+    uint8_t depth = static_cast<uint8_t>(std::min(limits.maxMoves, 255));
+    if (solution.result == MateResult::NoMate && !limits.checksOnly) {
+        AnalysisRecord record;
+        if (!analysisCache->probe(board.key, record) || (record.kind == AnalysisNoMate && record.depth < depth))
+            analysisCache->store({ board.key, Move(), 0, depth, AnalysisNoMate });
+        return;
+    }
+    if (solution.result != MateResult::Mate)
+        return;
+
+    AnalysisKind kind = solution.shortest ? AnalysisShortestMate : AnalysisMate;
+    for (size_t ply = 0; ply < solution.line.size(); ply++) {
+        int movesLeft = solution.mateIn - static_cast<int>(ply + 1) / 2;
+        int16_t score = static_cast<int16_t>((ply % 2 == 0) ? movesLeft : -movesLeft);
+        AnalysisRecord record;
+        bool known = analysisCache->probe(board.key, record) && record.kind != AnalysisNoMate &&
+                     (record.kind == AnalysisShortestMate || std::abs(record.score) <= movesLeft);
+        if (!known || (kind == AnalysisShortestMate && record.kind != AnalysisShortestMate))
+            analysisCache->store({ board.key, solution.line[ply], score, depth, kind });
+        board.push(solution.line[ply]);
+    }
+    for (size_t ply = 0; ply < solution.line.size(); ply++)
+        board.pop();
+}
+
+/*
+df-pn finds a mate, not necessarily the shortest. When the shortest is wanted, the search runs again with a tighter limit
+until it fails; proving that no shorter mate exists often costs far more than finding the first one.
+The table is kept between the runs of one solve, since its entries record the depths they hold for.
+Each line is read off right after its proof, while the positions along it are still in the table.
+*/
+MateSolution MateSolver::solve(Chessboard &board, const MateSearchLimits &searchLimits) {
+    MateSolution solution;
+    limits = searchLimits;
+    limits.maxMoves = std::max(1, std::min(limits.maxMoves, INT16_MAX / 2));
+    int maxMoves = limits.maxMoves;
+    nodes = 0;
+    if (solveFromCache(board, solution))
+        return solution;
+    // Moving on to a new generation empties the table without touching it, except once every 255 solves when the counter wraps
+    if (++generation == 0) {
+        std::fill(table.begin(), table.end(), MateEntry{});
+        generation = 1;
+    }
+
+    while (true) {
+        search(board, 0, INFINITE_NUMBER, INFINITE_NUMBER);
+        NodeValue root = lookup(board.key, 2 * limits.maxMoves - 1);
+        if (root.proof == 0) {
+            solution.result = MateResult::Mate;
+            solution.mateIn = (root.distance + 1) / 2;
+            limits.maxMoves = solution.mateIn;
+            solution.line.clear();
+            extractLine(board, solution);
+            // Proofs found later through transpositions can make the line shorter than the distance stored at the root
+            if (!solution.line.empty())
+                solution.mateIn = static_cast<int>(solution.line.size() + 1) / 2;
+            solution.shortest = solution.mateIn == 1;
+            if (!limits.shortest || solution.shortest)
+                break;
+            limits.maxMoves = solution.mateIn - 1;
+            continue;
+        }
+        if (root.disproof == 0 && solution.result == MateResult::Mate)
+            solution.shortest = !limits.checksOnly;
+        else if (root.disproof == 0)
+            solution.result = MateResult::NoMate;
+        break;
+    }
+    solution.nodes = nodes;
+    limits.maxMoves = maxMoves;
+    recordSolution(board, solution);
+    return solution;
+}
@@ -0,0 +1,99 @@
+#ifndef MATE_SOLVER_H
+#define MATE_SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "analysis_cache.h"
+#include "chessboard.h"
+#include "memory.h"
+#include "move.h"
+
+/*
+Depth-first proof-number (df-pn) mate solver.
+Proof-number search grows the game tree towards the positions that are cheapest to settle: the proof number of a position
+is how many more positions must be shown to be mates to prove it, and the disproof number how many must be shown not to be.
+At the attacker's turn one mating move suffices, so proof numbers take the minimum over the moves and disproof numbers the sum;
+at the defender's turn every reply must be mated, which swaps the two. Forced mates have few defender replies,
+so the search dives straight down the narrow lines that long mates are made of, where alpha-beta would search every move to full depth.
+
+df-pn runs the same search depth first, only leaving a position once its numbers pass thresholds handed down by its parent,
+and keeps the numbers of visited positions in a fixed-size table instead of an explicit tree, so memory use is bounded.
+More information can be found here:
+https://www.chessprogramming.org/Proof-Number_Search#Depth-First_Proof-Number_Search
+
+Reported mates are always sound. Repetitions count as failing to mate, and since that depends on the path taken,
+a position may occasionally be marked as no mate when another path reaches it, which can hide a mate or a shorter one;
+like most solvers, this one accepts that in exchange for cutting off the endless shuffling of pieces.
+*/
+
+// Limits of a mate search
+struct MateSearchLimits {
+    int maxMoves = 10; // Longest mate looked for, in moves of the attacker
+    uint64_t maxNodes = 10000000; // The search gives up once it has visited this many positions
+    bool checksOnly = false; // Only consider checking moves for the attacker, which solves many problems far faster
+    bool shortest = false; // Keep searching for shorter mates once one is found
+};
+
+enum class MateResult {
+    Mate,
+    NoMate, // No mate within the move limit
+    Unknown // The node limit was reached first
+};
+
+struct MateSolution {
+    MateResult result = MateResult::Unknown;
+    int mateIn = 0; // Moves of the attacker, counting the mating move
+    bool shortest = false; // Whether no shorter mate exists
+    std::vector<Move> line; // Attacker moves followed by the longest-resisting replies, ending in mate
+    uint64_t nodes = 0;
+};
+
+// Proof and disproof numbers of a position, along with the length of its mate once proven
+struct MateEntry {
+    uint64_t key;
+    uint32_t proof;
+    uint32_t disproof;
+    uint32_t work : 24; // Positions searched below this one, so that expensive results are the last to be replaced
+    uint32_t generation : 8; // Solve that stored the entry; entries of earlier solves count as empty
+    uint16_t distance; // Plies to mate once proven
+    int16_t remaining; // Plies that were left when the entry was stored; the key is only ever looked up with the same number
+};
+
+static_assert(sizeof(MateEntry) == 24, "The generation shares a word with the work so that the table holds as many entries");
+
+class MateSolver {
+private:
+    LargeArray<MateEntry> table;
+    uint8_t generation = 0; // Of the current solve; never zero during one, so that a freshly zeroed table reads as empty
+    MateSearchLimits limits;
+    uint64_t nodes = 0;
+    AnalysisCache *analysisCache = nullptr;
+
+    struct NodeValue {
+        uint32_t proof;
+        uint32_t disproof;
+        uint16_t distance;
+    };
+
+    NodeValue lookup(uint64_t key, int remaining) const;
+    void store(uint64_t key, const NodeValue &value, int remaining, uint64_t work);
+    MoveList candidateMoves(Chessboard &board, bool attacker);
+    NodeValue childValue(Chessboard &board, Move move, int remaining);
+    void search(Chessboard &board, int ply, uint32_t proofThreshold, uint32_t disproofThreshold);
+    void extractLine(Chessboard &board, MateSolution &solution);
+    bool solveFromCache(Chessboard &board, MateSolution &solution);
+    void recordSolution(Chessboard &board, const MateSolution &solution);
+
+public:
+    // The table takes about the given number of megabytes, rounded down to a power of two entries
+    explicit MateSolver(size_t tableMegabytes = 64);
+
+    // Answer from, and record results in, a persistent cache; nullptr to stop using one
+    void setAnalysisCache(AnalysisCache *cache) { analysisCache = cache; }
+
+    // Look for a forced mate by the side to move, leaving the board as it was
+    MateSolution solve(Chessboard &board, const MateSearchLimits &searchLimits);
+};
+
+#endif // MATE_SOLVER_H
@@ -0,0 +1,217 @@
+#include "mcts.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// A leaf is expanded on its second visit, so that positions reached only once do not fill the arena with their children
+static const uint32_t EXPANSION_VISITS = 2;
+// No chess position has more legal moves than this
+static const uint64_t MAX_MOVES = 256;
+
+static bool gameOver(GameStatus status) {
+    return status != GameStatus::Ongoing && status != GameStatus::Check;
+}
+
+// Same policy as self-play, with a little more variety: a random capture when there is one, otherwise any random move
+static Move playoutMove(const MoveList &legalMoves, PRNG &prng) {
+    int captures = 0;
+    for (size_t i = 0; i < legalMoves.size(); i++)
+        captures += legalMoves[i].isCapture();
+    if (!captures)
+        return legalMoves[prng.nextBelow(legalMoves.size())];
+    for (int capture = static_cast<int>(prng.nextBelow(captures)), i = 0;; i++)
+        if (legalMoves[i].isCapture() && capture-- == 0)
+            return legalMoves[i];
+}
+
+// Play random moves to the end of the game and take them back, returning half points for the side to move at the start
+static uint32_t playout(Chessboard &board, PRNG &prng, int maxPlies) {
+    Color side = board.turn;
+    MoveList legalMoves;
+    uint32_t result = 1;
+    int plies = 0;
+    while (plies < maxPlies) {
+        GameStatus status = board.gameStatus(legalMoves);
+        if (status == GameStatus::Checkmate) {
+            result = (board.turn == side) ? 0 : 2;
+            break;
+        }
+        if (gameOver(status))
+            break;
+        board.push(playoutMove(legalMoves, prng));
+        plies++;
+    }
+    for (int i = 0; i < plies; i++)
+        board.pop();
+    return result;
+}
+
+MctsSearch::MctsSearch(size_t arenaMegabytes) {
+    arena.allocate(std::max<size_t>(1024, std::min<size_t>(arenaMegabytes * 1024 * 1024 / sizeof(MctsNode), UINT32_MAX)), MemoryMctsTree);
+}
+
+/*
+Claim a leaf and give it one child per legal move, or mark it terminal when the game is over there.
+Returns false when another thread got to it first or the arena has no room left.
+*/
+bool MctsSearch::expand(MctsNode &node, Chessboard &board) {
+    if (arenaUsed.load(std::memory_order_relaxed) + MAX_MOVES > arena.size())
+        return false;
+    uint8_t expected = Leaf;
+    if (!node.state.compare_exchange_strong(expected, Expanding, std::memory_order_acquire))
+        return false;
+
+    MoveList legalMoves;
+    GameStatus status = board.gameStatus(legalMoves);
+    if (gameOver(status)) {
+        node.terminal = (status == GameStatus::Checkmate) ? 0 : 1;
+        node.state.store(Terminal, std::memory_order_release);
+        return true;
+    }
+
+    uint64_t first = arenaUsed.fetch_add(legalMoves.size(), std::memory_order_relaxed);
+    if (first + legalMoves.size() > arena.size()) {
+        node.state.store(Leaf, std::memory_order_release);
+        return false;
+    }
+    for (size_t i = 0; i < legalMoves.size(); i++) {
+        MctsNode &child = arena[first + i];
+        child.visits.store(0, std::memory_order_relaxed);
+        child.score.store(0, std::memory_order_relaxed);
+        child.firstChild = 0;
+        child.childCount = 0;
+        child.move = legalMoves[i];
+        child.state.store(Leaf, std::memory_order_relaxed);
+        child.terminal = 0;
+    }
+    node.firstChild = static_cast<uint32_t>(first);
+    node.childCount = static_cast<uint16_t>(legalMoves.size());
+    // Publishes the children along with the state, for threads that read the state with acquire
+    node.state.store(Expanded, std::memory_order_release);
+    return true;
+}
+
+// Pick the child with the highest upper confidence bound, trying every child once before any twice
+uint32_t MctsSearch::selectChild(const MctsNode &node) const {
+    double logVisits = std::log(static_cast<double>(std::max(1u, node.visits.load(std::memory_order_relaxed))));
+    uint32_t best = node.firstChild;
+    double bestValue = -1;
+    for (uint32_t i = node.firstChild; i < node.firstChild + node.childCount; i++) {
+        uint32_t visits = arena[i].visits.load(std::memory_order_relaxed);
+        if (visits == 0)
+            return i;
+        double value = arena[i].score.load(std::memory_order_relaxed) / (2.0 * visits) + limits.exploration * std::sqrt(logVisits / visits);
+        if (value > bestValue) {
+            bestValue = value;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/*
+One iteration: walk down to a leaf, counting a visit at every node on the way as a virtual loss,
+expand the leaf if it has been visited before, play out the game from the position reached and add the result back up the path.
+*/
+void MctsSearch::iterate(Chessboard &board, PRNG &prng, std::vector<uint32_t> &path) {
+    path.assign(1, 0);
+    arena[0].visits.fetch_add(1, std::memory_order_relaxed);
+    bool expanded = false;
+    while (true) {
+        MctsNode &node = arena[path.back()];
+        uint8_t state = node.state.load(std::memory_order_acquire);
+        if (state == Leaf && !expanded && node.visits.load(std::memory_order_relaxed) >= EXPANSION_VISITS && expand(node, board)) {
+            // Take one step into the new children, so that the playout starts from a position the tree has not seen yet
+            expanded = true;
+            state = node.state.load(std::memory_order_acquire);
+        }
+        if (state != Expanded || node.childCount == 0)
+            break;
+        uint32_t child = selectChild(node);
+        arena[child].visits.fetch_add(1, std::memory_order_relaxed);
+        board.push(arena[child].move);
+        path.push_back(child);
+        if (expanded)
+            break;
+    }
+
+    const MctsNode &leaf = arena[path.back()];
+    uint32_t points = (leaf.state.load(std::memory_order_acquire) == Terminal) ? leaf.terminal : playout(board, prng, limits.maxPlayoutPlies);
+
+    // The score of a node belongs to the side that moved into it, which alternates going up the path
+    for (size_t i = path.size(); i-- > 0;) {
+        points = 2 - points;
+        arena[path[i]].score.fetch_add(points, std::memory_order_relaxed);
+    }
+    for (size_t i = 1; i < path.size(); i++)
+        board.pop();
+}
+
+MctsResult MctsSearch::search(const Chessboard &board, const MctsLimits &searchLimits) {
+    MctsResult result;
+    limits = searchLimits;
+    limits.threads = std::max(1, limits.threads);
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(limits.maxMilliseconds);
+
+    MctsNode &root = arena[0];
+    root.visits.store(0, std::memory_order_relaxed);
+    root.score.store(0, std::memory_order_relaxed);
+    root.state.store(Leaf, std::memory_order_relaxed);
+    arenaUsed.store(1, std::memory_order_relaxed);
+    Chessboard rootBoard = board;
+    result.status = rootBoard.gameStatus();
+    if (gameOver(result.status))
+        return result;
+    expand(root, rootBoard);
+    if (root.state.load(std::memory_order_relaxed) != Expanded)
+        return result;
+
+    // Each thread plays out on its own copy of the board with its own generator
+    std::atomic<uint64_t> started(0), finished(0);
+    auto worker = [&](int thread) {
+        Chessboard threadBoard = board;
+        PRNG prng(limits.seed ^ (static_cast<uint64_t>(thread) * 0x9E3779B97F4A7C15ULL));
+        std::vector<uint32_t> path;
+        uint64_t playouts = 0;
+        while (started.fetch_add(1, std::memory_order_relaxed) < limits.maxPlayouts) {
+            if (limits.maxMilliseconds && std::chrono::steady_clock::now() >= deadline)
+                break;
+            iterate(threadBoard, prng, path);
+            playouts++;
+        }
+        finished.fetch_add(playouts, std::memory_order_relaxed);
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < limits.threads; i++)
+        threads.emplace_back(worker, i);
+    worker(0);
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.playouts = finished.load();
+    result.nodes = std::min<uint64_t>(arenaUsed.load(), arena.size());
+
+    for (uint32_t i = root.firstChild; i < root.firstChild + root.childCount; i++) {
+        uint32_t visits = arena[i].visits.load();
+        result.rootMoves.push_back({ arena[i].move, visits, visits ? arena[i].score.load() / (2.0 * visits) : 0.0 });
+    }
+    std::stable_sort(result.rootMoves.begin(), result.rootMoves.end(), [](const MctsMoveStat &a, const MctsMoveStat &b) {
+        return a.visits > b.visits;
+    });
+    result.bestMove = result.rootMoves[0].move;
+
+    // Follow the most visited child down for as long as the tree goes
+    for (const MctsNode *node = &root; node->state.load() == Expanded && node->childCount;) {
+        const MctsNode *next = &arena[node->firstChild];
+        for (uint32_t i = node->firstChild; i < node->firstChild + node->childCount; i++)
+            if (arena[i].visits.load() > next->visits.load())
+                next = &arena[i];
+        if (!next->visits.load())
+            break;
+        result.line.push_back(next->move);
+        node = next;
+    }
+    return result;
+}
@@ -0,0 +1,91 @@
+#ifndef MCTS_H
+#define MCTS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "chessboard.h"
+#include "memory.h"
+#include "move.h"
+#include "prng.h"
+
+/*
+Monte Carlo tree search, a second search engine next to the mate solver.
+Every iteration walks down the tree choosing moves by UCT (upper confidence bounds applied to trees),
+which balances moves that scored well so far against moves that have been tried little, expands the position it reaches,
+and plays a random game from there to the end. The result of that playout is added to every position on the way back up.
+More information can be found here:
+https://www.chessprogramming.org/Monte-Carlo_Tree_Search
+
+Worker threads share one tree. A thread counts its visit to a position on the way down, before the playout result is known,
+so that until the result arrives the visit reads as a loss (a virtual loss) and steers the other threads towards other moves.
+Nodes come from an arena sized up front on huge pages and handed out with a single atomic counter, so expansion never locks or allocates;
+once the arena is full, leaves simply stop being expanded and searching goes on with playouts alone.
+*/
+
+// Limits and settings of a Monte Carlo search; the search stops at whichever limit comes first
+struct MctsLimits {
+    uint64_t maxPlayouts = 100000;
+    int maxMilliseconds = 0; // No time limit when zero
+    int threads = 1;
+    uint64_t seed = 1;
+    int maxPlayoutPlies = 200; // Playouts reaching this length count as draws
+    double exploration = 1.4; // Weight of the exploration term of UCT
+};
+
+// Statistics of a move at the root
+struct MctsMoveStat {
+    Move move;
+    uint32_t visits;
+    double score; // Average result for the side to move, from 0 for a loss to 1 for a win
+};
+
+struct MctsResult {
+    GameStatus status = GameStatus::Ongoing; // Of the root position; nothing is searched once the game is over there
+    Move bestMove; // The most visited move at the root, or the null move when the game is over
+    std::vector<Move> line; // Most visited moves from the root down
+    std::vector<MctsMoveStat> rootMoves; // Most visited first
+    uint64_t playouts = 0;
+    uint64_t nodes = 0;
+    double seconds = 0;
+};
+
+struct MctsNode {
+    // Visits include those still in progress, which count as losses until their result is added
+    std::atomic<uint32_t> visits;
+    // Results in half points for the side that played the move into this node: two per win and one per draw
+    std::atomic<uint32_t> score;
+    uint32_t firstChild; // Children are consecutive in the arena
+    uint16_t childCount;
+    Move move;
+    std::atomic<uint8_t> state; // One of MctsSearch::NodeState
+    uint8_t terminal; // Half points for the side to move once the game is over here
+};
+
+class MctsSearch {
+private:
+    enum NodeState : uint8_t {
+        Leaf,
+        Expanding, // Claimed by a thread, whose children are not ready yet
+        Expanded,
+        Terminal // The game is over in this position
+    };
+
+    LargeArray<MctsNode> arena;
+    std::atomic<uint64_t> arenaUsed;
+    MctsLimits limits;
+
+    bool expand(MctsNode &node, Chessboard &board);
+    uint32_t selectChild(const MctsNode &node) const;
+    void iterate(Chessboard &board, PRNG &prng, std::vector<uint32_t> &path);
+
+public:
+    // The arena takes about the given number of megabytes
+    explicit MctsSearch(size_t arenaMegabytes = 256);
+
+    // Search the position on the board, leaving it as it was
+    MctsResult search(const Chessboard &board, const MctsLimits &searchLimits);
+};
+
+#endif // MCTS_H
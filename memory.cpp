@@ -0,0 +1,114 @@
+#include "memory.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+
+// Zero-initialized before any static initializer runs, so tables built during static initialization are counted too
+static std::atomic<uint64_t> liveBytes[MEMORY_SUBSYSTEM_COUNT];
+static std::atomic<uint64_t> peakBytes[MEMORY_SUBSYSTEM_COUNT];
+static std::atomic<uint64_t> hugeBytes[MEMORY_SUBSYSTEM_COUNT];
+static std::atomic<uint64_t> allocationCounts[MEMORY_SUBSYSTEM_COUNT];
+
+static const char *subsystemNames[MEMORY_SUBSYSTEM_COUNT] = { "slider tables", "mate solver", "mcts tree", "thread arenas" };
+
+// Map memory aligned to a huge page, by mapping a huge page more than needed and unmapping the ends
+static void *mapAligned(size_t bytes) {
+    size_t padded = bytes + HUGE_PAGE_SIZE;
+    void *mapping = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+    uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+    uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    if (aligned > start)
+        munmap(mapping, aligned - start);
+    if (start + padded > aligned + bytes)
+        munmap(reinterpret_cast<void *>(aligned + bytes), start + padded - (aligned + bytes));
+    return reinterpret_cast<void *>(aligned);
+}
+
+LargeAllocation allocateLarge(size_t bytes, MemorySubsystem subsystem) {
+    LargeAllocation allocation;
+    allocation.subsystem = subsystem;
+    if (bytes == 0)
+        return allocation;
+
+    // Small tables would waste most of a huge page, so they get ordinary pages
+    size_t pageSize = 4096;
+    if (bytes >= HUGE_PAGE_SIZE / 4)
+        pageSize = HUGE_PAGE_SIZE;
+    allocation.bytes = (bytes + pageSize - 1) & ~(pageSize - 1);
+
+    void *memory = nullptr;
+    if (pageSize == HUGE_PAGE_SIZE) {
+#ifdef MAP_HUGETLB
+        memory = mmap(nullptr, allocation.bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory == MAP_FAILED)
+            memory = nullptr;
+        else
+            allocation.backing = HugePages;
+#endif
+        if (!memory && (memory = mapAligned(allocation.bytes))) {
+#ifdef MADV_HUGEPAGE
+            if (madvise(memory, allocation.bytes, MADV_HUGEPAGE) == 0)
+                allocation.backing = AdvisedHugePages;
+#endif
+        }
+    } else {
+        memory = mmap(nullptr, allocation.bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+            memory = nullptr;
+    }
+    if (!memory) {
+        std::fprintf(stderr, "Out of memory allocating %zu bytes for the %s\n", bytes, subsystemNames[subsystem]);
+        std::abort();
+    }
+    allocation.memory = memory;
+
+    uint64_t live = liveBytes[subsystem].fetch_add(allocation.bytes) + allocation.bytes;
+    for (uint64_t peak = peakBytes[subsystem].load(); live > peak && !peakBytes[subsystem].compare_exchange_weak(peak, live);)
+        ;
+    if (allocation.backing != SmallPages)
+        hugeBytes[subsystem].fetch_add(allocation.bytes);
+    allocationCounts[subsystem].fetch_add(1);
+    return allocation;
+}
+
+void freeLarge(LargeAllocation &allocation) {
+    if (!allocation.memory)
+        return;
+    munmap(allocation.memory, allocation.bytes);
+    liveBytes[allocation.subsystem].fetch_sub(allocation.bytes);
+    if (allocation.backing != SmallPages)
+        hugeBytes[allocation.subsystem].fetch_sub(allocation.bytes);
+    allocation = LargeAllocation();
+}
+
+MemoryUsage memoryUsage(MemorySubsystem subsystem) {
+    return { liveBytes[subsystem].load(), peakBytes[subsystem].load(), hugeBytes[subsystem].load(), allocationCounts[subsystem].load() };
+}
+
+const char *memorySubsystemName(MemorySubsystem subsystem) {
+    return subsystemNames[subsystem];
+}
+
+void printMemoryReport(std::FILE *output) {
+    std::fprintf(output, "%-16s %12s %12s %12s %12s\n", "subsystem", "allocations", "current KB", "peak KB", "huge KB");
+    for (int i = 0; i < MEMORY_SUBSYSTEM_COUNT; i++) {
+        MemoryUsage usage = memoryUsage(static_cast<MemorySubsystem>(i));
+        std::fprintf(output, "%-16s %12llu %12llu %12llu %12llu\n", subsystemNames[i], static_cast<unsigned long long>(usage.allocations),
+                     static_cast<unsigned long long>(usage.bytes / 1024), static_cast<unsigned long long>(usage.peakBytes / 1024),
+                     static_cast<unsigned long long>(usage.hugePageBytes / 1024));
+    }
+
+    // Advised pages are only a request, so report what the kernel actually gave the whole process
+    std::FILE *rollup = std::fopen("/proc/self/smaps_rollup", "r");
+    if (!rollup)
+        return;
+    char line[256];
+    unsigned long long kilobytes;
+    while (std::fgets(line, sizeof(line), rollup))
+        if (std::sscanf(line, "AnonHugePages: %llu kB", &kilobytes) == 1)
+            std::fprintf(output, "Transparent huge pages in use: %llu KB\n", kilobytes);
+    std::fclose(rollup);
+}
@@ -0,0 +1,131 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+
+/*
+Memory for the engine's large tables, taken from 2 MB huge pages where the system allows it.
+Lookups into a table of many megabytes land on a different 4 KB page almost every time, and each page needs its own
+TLB entry to translate its address; with 2 MB pages one entry covers 512 times as much of the table, so far fewer lookups miss.
+
+Memory comes from explicitly reserved huge pages (MAP_HUGETLB) when there are any. Otherwise the mapping is aligned to 2 MB and
+the kernel is advised to back it with transparent huge pages (MADV_HUGEPAGE), and failing that it stays on ordinary pages.
+Every allocation is tagged with the subsystem it belongs to, so that memory use and page backing can be reported per subsystem.
+More information can be found here:
+https://www.kernel.org/doc/html/latest/admin-guide/mm/transhuge.html
+*/
+
+enum MemorySubsystem {
+    MemorySliderTables,
+    MemoryMateSolver,
+    MemoryMctsTree,
+    MemoryThreadArenas,
+    MEMORY_SUBSYSTEM_COUNT
+};
+
+// How an allocation is backed, from best to worst
+enum PageBacking : uint8_t {
+    HugePages, // Reserved huge pages, guaranteed
+    AdvisedHugePages, // Transparent huge pages, up to the kernel
+    SmallPages
+};
+
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+struct LargeAllocation {
+    void *memory = nullptr;
+    size_t bytes = 0; // Rounded up to whole pages
+    MemorySubsystem subsystem = MemorySliderTables;
+    PageBacking backing = SmallPages;
+};
+
+// Totals of one subsystem
+struct MemoryUsage {
+    uint64_t bytes; // Currently allocated
+    uint64_t peakBytes;
+    uint64_t hugePageBytes; // Currently allocated with reserved or advised huge pages
+    uint64_t allocations; // Made so far
+};
+
+/*
+Map zeroed memory for a table of at least the given size. Tables of a quarter of a huge page or more are rounded up to whole huge pages.
+Running out of memory ends the program with a message, as it would for any other allocation.
+*/
+LargeAllocation allocateLarge(size_t bytes, MemorySubsystem subsystem);
+void freeLarge(LargeAllocation &allocation);
+
+MemoryUsage memoryUsage(MemorySubsystem subsystem);
+const char *memorySubsystemName(MemorySubsystem subsystem);
+// Print the usage of every subsystem, along with how much of the process the kernel actually backs with huge pages
+void printMemoryReport(std::FILE *output);
+
+/*
+Fixed-size array of a large table. Elements start out as all zero bytes rather than being constructed,
+which suits tables of plain entries and counters whose zero value means empty.
+*/
+template<typename T>
+class LargeArray {
+private:
+    LargeAllocation allocation;
+    size_t count = 0;
+
+public:
+    static_assert(std::is_trivially_destructible<T>::value, "Elements are never destroyed");
+
+    LargeArray() = default;
+    LargeArray(const LargeArray &) = delete;
+    LargeArray &operator=(const LargeArray &) = delete;
+    ~LargeArray() { freeLarge(allocation); }
+
+    // Replace the contents with the given number of zeroed elements
+    void allocate(size_t elements, MemorySubsystem subsystem) {
+        freeLarge(allocation);
+        allocation = allocateLarge(elements * sizeof(T), subsystem);
+        count = elements;
+    }
+
+    size_t size() const { return count; }
+    T *data() { return static_cast<T *>(allocation.memory); }
+    const T *data() const { return static_cast<const T *>(allocation.memory); }
+    T *begin() { return data(); }
+    T *end() { return data() + count; }
+    T &operator[](size_t index) { return data()[index]; }
+    const T &operator[](size_t index) const { return data()[index]; }
+};
+
+/*
+Bump allocator over a block of huge pages, one per thread, for scratch data that lives as long as a search or a pass.
+Nothing is freed on its own; reset hands the whole block out again. Giving every thread its own arena keeps
+threads from sharing cache lines, and the memory is first touched by the thread that uses it.
+*/
+class ThreadArena {
+private:
+    LargeAllocation allocation;
+    size_t used = 0;
+
+public:
+    explicit ThreadArena(size_t bytes) : allocation(allocateLarge(bytes, MemoryThreadArenas)) {}
+    ThreadArena(ThreadArena &&other) noexcept : allocation(other.allocation), used(other.used) { other.allocation = LargeAllocation(); }
+    ThreadArena(const ThreadArena &) = delete;
+    ThreadArena &operator=(const ThreadArena &) = delete;
+    ~ThreadArena() { freeLarge(allocation); }
+
+    // Returns nullptr once the arena is full
+    void *allocate(size_t bytes, size_t alignment = 64) {
+        size_t start = (used + alignment - 1) & ~(alignment - 1);
+        if (start + bytes > allocation.bytes)
+            return nullptr;
+        used = start + bytes;
+        return static_cast<char *>(allocation.memory) + start;
+    }
+    template<typename T>
+    T *allocate(size_t count) {
+        return static_cast<T *>(allocate(count * sizeof(T), alignof(T) > 64 ? alignof(T) : 64));
+    }
+    void reset() { used = 0; }
+};
+
+#endif // MEMORY_H
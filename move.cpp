@@ -1,26 +1,16 @@
 #include "move.h"
-#include "bitboard.h"
-#include <iostream>
-
-// Constructors
-Move::Move() { this->move = 0; } // Represents the null move, quiet and does not change board state
-Move::Move(Square fromSquare, Square toSquare, MoveType moveType) { this->move = (moveType << 12) | (static_cast<unsigned short>(toSquare << 6)) | (static_cast<unsigned short>(fromSquare)); }
-Move::Move(Bitboard fromSquare, Bitboard toSquare, MoveType moveType) { this->move = (moveType << 12) | (GET_LSB(toSquare << 6)) | (GET_LSB(fromSquare)); }
-
-// Getter functions
-Square Move::getFromSquare() {return static_cast<Square>(this->move & 0x3F); }
-Square Move::getToSquare() { return static_cast<Square>((this->move >> 6) & 0x3F); }
-Move::MoveType Move::getMoveType() { return static_cast<MoveType>((this->move >> 12) & 0xF); }
-bool Move::isQuiet() { return !(static_cast<bool>(this->move >> 12)); } // Inverted because quiet is 0b0000, which is false
-bool Move::isCapture() { return static_cast<bool>(this->move & (1 << 15)); }
-bool Move::isPromotion() { return static_cast<bool>(this->move & (1 << 14)); }
-bool Move::isNull() { return !(this->move); }
 
 // Display functions
-void Move::printMove() {
-    std::cout << squareNames[this->getFromSquare()] << " --> " << squareNames[this->getToSquare()];
-    if (this->isQuiet()) std::cout << " Quiet";
-    if (this->isCapture()) std::cout << " Capture";
-    if (this->isPromotion()) std::cout << " Promotion";
-    std:: cout << std::endl;
-}
\ No newline at end of file
+int Move::toUCI(char *buffer) const {
+    const char *from = squareNames[getFromSquare()], *to = squareNames[getToSquare()];
+    int length = 0;
+    buffer[length++] = from[0];
+    buffer[length++] = from[1];
+    buffer[length++] = to[0];
+    buffer[length++] = to[1];
+    // The low two bits of a promotion's type select the piece, from knight to queen
+    if (isPromotion())
+        buffer[length++] = "nbrq"[getMoveType() & 0x3];
+    buffer[length] = '\0';
+    return length;
+}
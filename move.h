@@ -2,8 +2,8 @@
 #define MOVE_H
 
 #include <cstdint>
+#include <type_traits>
 #include <vector>
-#include <string>
 #include "bitboard.h"
 #include "types.h"
 
@@ -43,8 +43,8 @@ public:
         QueenPromotionCapture = 15 // 0b1111
     };
 
-    // Index-based square names for move output
-    std::string squareNames[64] = {
+    // Index-based square names for move output, shared by every move
+    static constexpr char squareNames[64][3] = {
         "h1", "g1", "f1", "e1", "d1", "c1", "b1", "a1",
         "h2", "g2", "f2", "e2", "d2", "c2", "b2", "a2",
         "h3", "g3", "f3", "e3", "d3", "c3", "b3", "a3",
@@ -55,24 +55,41 @@ public:
         "h8", "g8", "f8", "e8", "d8", "c8", "b8", "a8"
     };
 
+    // Buffer sizes, including the terminator, that always fit a formatted move: "e7e8q" and "Qa1xb2=Q#" at the longest
+    static constexpr int UCI_BUFFER_SIZE = 6;
+    static constexpr int SAN_BUFFER_SIZE = 10;
+
     // Constructors
-    Move();
-    Move(Square fromSquare, Square toSquare, MoveType moveType);
-    Move(Bitboard fromSquare, Bitboard toSquare, MoveType moveType);
+    constexpr Move() : move(0) {} // Represents the null move, quiet and does not change board state
+    constexpr Move(Square fromSquare, Square toSquare, MoveType moveType)
+        : move(static_cast<uint16_t>((moveType << 12) | (toSquare << 6) | fromSquare)) {}
+    constexpr Move(Bitboard fromSquare, Bitboard toSquare, MoveType moveType)
+        : move(static_cast<uint16_t>((moveType << 12) | (GET_LSB(toSquare) << 6) | GET_LSB(fromSquare))) {}
+    // Rebuild a move from the encoding returned by getEncoding, as stored in files
+    explicit constexpr Move(uint16_t encoding) : move(encoding) {}
 
     // Getter functions
-    Square getFromSquare();
-    Square getToSquare();
-    MoveType getMoveType();
-    bool isQuiet();
-    bool isCapture();
-    bool isPromotion();
-    bool isNull();
+    constexpr Square getFromSquare() const { return static_cast<Square>(move & 0x3F); }
+    constexpr Square getToSquare() const { return static_cast<Square>((move >> 6) & 0x3F); }
+    constexpr MoveType getMoveType() const { return static_cast<MoveType>((move >> 12) & 0xF); }
+    constexpr bool isQuiet() const { return !(move >> 12); } // Inverted because quiet is 0b0000, which is false
+    constexpr bool isCapture() const { return move & (1 << 15); }
+    constexpr bool isPromotion() const { return move & (1 << 14); }
+    constexpr bool isNull() const { return !move; }
+    constexpr uint16_t getEncoding() const { return move; }
+
+    constexpr bool operator==(Move other) const { return move == other.move; }
+    constexpr bool operator!=(Move other) const { return move != other.move; }
 
     // Display functions
-    void printMove();
+    // Write the move in coordinate notation, such as e2e4 or e7e8q, returning its length
+    int toUCI(char *buffer) const;
 };
 
+// Moves are copied around by the hundred during generation, so they must stay as cheap as their encoding
+static_assert(sizeof(Move) == 2, "Move must stay a bare 16-bit encoding");
+static_assert(std::is_trivially_copyable<Move>::value, "Move must stay plain data");
+
 typedef std::vector<Move> MoveList;
 
 #endif // MOVE_H
\ No newline at end of file
@@ -0,0 +1,540 @@
+#ifndef MOVE_GENERATION_H
+#define MOVE_GENERATION_H
+
+#include "attacks.h"
+#include "bitboard.h"
+#include "move.h"
+#include "position.h"
+#include "stats.h"
+#include "trace.h"
+#include "types.h"
+
+/*
+Move generators are templates over a sink that receives the moves.
+Generators hand the sink whole sets of destination squares at once, so a sink that only counts moves can take a population count
+instead of creating every move, and a sink that only needs to know whether any move exists can stop generation at the first one.
+Pawns are generated for all of them at once, so their sets come with a fixed offset from each destination back to its origin instead.
+Every sink method returns false to stop generation, which the generators pass straight back to their caller.
+Generators are also specialized on the side to move, so that pawn directions, ranks and castling masks are constants.
+*/
+
+// Collects moves into a list
+struct MoveListSink {
+    MoveList &moves;
+
+    bool add(Move move) {
+        moves.push_back(move);
+        return true;
+    }
+    bool add(Square fromSquare, Bitboard toSquares, Move::MoveType type) {
+        while (toSquares)
+            moves.push_back(Move(fromSquare, static_cast<Square>(POP_LSB(toSquares)), type));
+        return true;
+    }
+    // Every destination expands into one move per promotion piece
+    bool addPromotions(Square fromSquare, Bitboard toSquares, bool capture) {
+        Move::MoveType first = capture ? Move::KnightPromotionCapture : Move::KnightPromotion;
+        while (toSquares) {
+            Square toSquare = static_cast<Square>(POP_LSB(toSquares));
+            for (int piece = 0; piece < 4; piece++)
+                moves.push_back(Move(fromSquare, toSquare, static_cast<Move::MoveType>(first + piece)));
+        }
+        return true;
+    }
+    // Each move comes from the square offset squares before its destination
+    bool addShifted(Bitboard toSquares, int offset, Move::MoveType type) {
+        while (toSquares) {
+            int toSquare = POP_LSB(toSquares);
+            moves.push_back(Move(static_cast<Square>(toSquare - offset), static_cast<Square>(toSquare), type));
+        }
+        return true;
+    }
+    bool addShiftedPromotions(Bitboard toSquares, int offset, bool capture) {
+        Move::MoveType first = capture ? Move::KnightPromotionCapture : Move::KnightPromotion;
+        while (toSquares) {
+            int toSquare = POP_LSB(toSquares);
+            for (int piece = 0; piece < 4; piece++)
+                moves.push_back(Move(static_cast<Square>(toSquare - offset), static_cast<Square>(toSquare), static_cast<Move::MoveType>(first + piece)));
+        }
+        return true;
+    }
+};
+
+// Counts moves without creating them
+struct MoveCountSink {
+    int count = 0;
+
+    bool add(Move) {
+        count++;
+        return true;
+    }
+    bool add(Square, Bitboard toSquares, Move::MoveType) {
+        count += COUNT_BITS(toSquares);
+        return true;
+    }
+    bool addPromotions(Square, Bitboard toSquares, bool) {
+        count += 4 * COUNT_BITS(toSquares);
+        return true;
+    }
+    bool addShifted(Bitboard toSquares, int, Move::MoveType) {
+        count += COUNT_BITS(toSquares);
+        return true;
+    }
+    bool addShiftedPromotions(Bitboard toSquares, int, bool) {
+        count += 4 * COUNT_BITS(toSquares);
+        return true;
+    }
+};
+
+// Stops generation at the first move
+struct AnyMoveSink {
+    bool found = false;
+
+    bool add(Move) {
+        found = true;
+        return false;
+    }
+    bool add(Square, Bitboard toSquares, Move::MoveType) {
+        found = toSquares != 0;
+        return !found;
+    }
+    bool addPromotions(Square, Bitboard toSquares, bool) {
+        found = toSquares != 0;
+        return !found;
+    }
+    bool addShifted(Bitboard toSquares, int, Move::MoveType) {
+        found = toSquares != 0;
+        return !found;
+    }
+    bool addShiftedPromotions(Bitboard toSquares, int, bool) {
+        found = toSquares != 0;
+        return !found;
+    }
+};
+
+// Calls a function with every move; the function returns false to stop generation
+template<typename Function>
+struct MoveCallbackSink {
+    Function function;
+
+    bool add(Move move) { return function(move); }
+    bool add(Square fromSquare, Bitboard toSquares, Move::MoveType type) {
+        while (toSquares)
+            if (!function(Move(fromSquare, static_cast<Square>(POP_LSB(toSquares)), type)))
+                return false;
+        return true;
+    }
+    bool addPromotions(Square fromSquare, Bitboard toSquares, bool capture) {
+        Move::MoveType first = capture ? Move::KnightPromotionCapture : Move::KnightPromotion;
+        while (toSquares) {
+            Square toSquare = static_cast<Square>(POP_LSB(toSquares));
+            for (int piece = 0; piece < 4; piece++)
+                if (!function(Move(fromSquare, toSquare, static_cast<Move::MoveType>(first + piece))))
+                    return false;
+        }
+        return true;
+    }
+    bool addShifted(Bitboard toSquares, int offset, Move::MoveType type) {
+        while (toSquares) {
+            int toSquare = POP_LSB(toSquares);
+            if (!function(Move(static_cast<Square>(toSquare - offset), static_cast<Square>(toSquare), type)))
+                return false;
+        }
+        return true;
+    }
+    bool addShiftedPromotions(Bitboard toSquares, int offset, bool capture) {
+        Move::MoveType first = capture ? Move::KnightPromotionCapture : Move::KnightPromotion;
+        while (toSquares) {
+            int toSquare = POP_LSB(toSquares);
+            for (int piece = 0; piece < 4; piece++)
+                if (!function(Move(static_cast<Square>(toSquare - offset), static_cast<Square>(toSquare), static_cast<Move::MoveType>(first + piece))))
+                    return false;
+        }
+        return true;
+    }
+};
+
+/*
+Restrictions on the moves generated.
+Legal generation works out where pieces may go before generating anything, so that no move ever has to be played and taken back;
+pseudo-legal generation uses the same generators with every restriction lifted.
+*/
+struct GenerationMasks {
+    // Squares pieces other than the king may move to: anything but our own pieces, narrowed to the checker and its ray in check
+    Bitboard targets;
+    // Our pieces that may only move along the line through our king
+    Bitboard pinned;
+    // Squares attacked by the opponent once our king is lifted off the board, which the king may not move to or castle through
+    Bitboard kingDanger;
+    // Enemy pieces giving check, and every square the opponent attacks
+    Bitboard checkers;
+    Bitboard attacked;
+    Square king;
+    bool legal;
+};
+
+// Squares attacked by one side, given the pieces that block sliders
+template<Color Them>
+Bitboard attackedSquares(const Position &position, Bitboard occupancy) {
+    const Bitboard *pieces = position.pieces[Them];
+    Bitboard attacks = pawnAttackSet(Them, pieces[Pawn]) | knightAttackSet(pieces[Knight]) | kingAttackSet(pieces[King]);
+    for (Bitboard sliders = pieces[Rook] | pieces[Queen]; sliders;)
+        attacks |= rookAttacks(static_cast<Square>(POP_LSB(sliders)), occupancy);
+    for (Bitboard sliders = pieces[Bishop] | pieces[Queen]; sliders;)
+        attacks |= bishopAttacks(static_cast<Square>(POP_LSB(sliders)), occupancy);
+    return attacks;
+}
+
+// Pieces of one side attacking a square, given the pieces that block sliders
+template<Color Them>
+Bitboard attackersTo(const Position &position, Square square, Bitboard occupancy) {
+    const Bitboard *pieces = position.pieces[Them];
+    return (pawnCaptures[~Them][square] & pieces[Pawn]) | (knightAttacks[square] & pieces[Knight]) | (kingAttacks[square] & pieces[King]) |
+           (rookAttacks(square, occupancy) & (pieces[Rook] | pieces[Queen])) | (bishopAttacks(square, occupancy) & (pieces[Bishop] | pieces[Queen]));
+}
+
+template<Color Us>
+GenerationMasks pseudoLegalMasks(const Position &position) {
+    GenerationMasks masks;
+    masks.targets = ~position.byColor[Us];
+    masks.pinned = 0ULL;
+    masks.kingDanger = masks.checkers = masks.attacked = 0ULL;
+    masks.king = position.pieces[Us][King] ? static_cast<Square>(GET_LSB(position.pieces[Us][King])) : Square::h1;
+    masks.legal = false;
+    return masks;
+}
+
+template<Color Us>
+GenerationMasks legalMasks(const Position &position) {
+    TRACE_SCOPE("legalMasks");
+    constexpr Color Them = ~Us;
+    // Positions without a king have no notion of check
+    if (!position.pieces[Us][King])
+        return pseudoLegalMasks<Us>(position);
+
+    GenerationMasks masks;
+    masks.legal = true;
+    masks.king = static_cast<Square>(GET_LSB(position.pieces[Us][King]));
+    const Bitboard *theirPieces = position.pieces[Them];
+    Bitboard orthogonalSliders = theirPieces[Rook] | theirPieces[Queen], diagonalSliders = theirPieces[Bishop] | theirPieces[Queen];
+
+    // In check, the checker must be captured or its ray blocked; in double check, only the king can move
+    Bitboard checkers = masks.checkers = attackersTo<Them>(position, masks.king, position.allPieces);
+    masks.targets = ~position.byColor[Us];
+    if (checkers)
+        masks.targets &= (checkers & (checkers - 1)) ? 0ULL : (checkers | betweenSquares[masks.king][GET_LSB(checkers)]);
+
+    // A piece is pinned when it is the only piece between our king and an enemy slider aiming at it
+    masks.pinned = 0ULL;
+    Bitboard snipers = (rookAttacks(masks.king, 0ULL) & orthogonalSliders) | (bishopAttacks(masks.king, 0ULL) & diagonalSliders);
+    while (snipers) {
+        Bitboard blockers = betweenSquares[masks.king][POP_LSB(snipers)] & position.allPieces;
+        if (blockers && !(blockers & (blockers - 1)))
+            masks.pinned |= blockers & position.byColor[Us];
+    }
+
+    /*
+    The king may not step back along the ray of a checking slider either, although our king hides that square from the attack map.
+    Extending each slider check through the king covers it; every other square on the line is already attacked or out of reach.
+    */
+    masks.attacked = masks.kingDanger = attackedSquares<Them>(position, position.allPieces);
+    for (Bitboard sliders = checkers & (orthogonalSliders | diagonalSliders); sliders;) {
+        Square checker = static_cast<Square>(POP_LSB(sliders));
+        masks.kingDanger |= lineSquares[masks.king][checker] & ~BITBOARD(checker);
+    }
+    return masks;
+}
+
+/*
+What it takes for a move to give check: the squares each piece type would attack the enemy king from,
+and our pieces standing alone between one of our sliders and that king, which give a discovered check by leaving the line.
+*/
+struct CheckInfo {
+    Bitboard checkSquares[6];
+    Bitboard discoverers;
+    Square enemyKing;
+};
+
+template<Color Us>
+CheckInfo checkInfo(const Position &position) {
+    constexpr Color Them = ~Us;
+    CheckInfo info = {};
+    if (!position.pieces[Them][King])
+        return info;
+
+    info.enemyKing = static_cast<Square>(GET_LSB(position.pieces[Them][King]));
+    info.checkSquares[Pawn] = pawnCaptures[Them][info.enemyKing];
+    info.checkSquares[Knight] = knightAttacks[info.enemyKing];
+    info.checkSquares[Bishop] = bishopAttacks(info.enemyKing, position.allPieces);
+    info.checkSquares[Rook] = rookAttacks(info.enemyKing, position.allPieces);
+    info.checkSquares[Queen] = info.checkSquares[Bishop] | info.checkSquares[Rook];
+
+    const Bitboard *ourPieces = position.pieces[Us];
+    Bitboard snipers = (rookAttacks(info.enemyKing, 0ULL) & (ourPieces[Rook] | ourPieces[Queen])) |
+                       (bishopAttacks(info.enemyKing, 0ULL) & (ourPieces[Bishop] | ourPieces[Queen]));
+    while (snipers) {
+        Bitboard blockers = betweenSquares[info.enemyKing][POP_LSB(snipers)] & position.allPieces;
+        if (blockers && !(blockers & (blockers - 1)))
+            info.discoverers |= blockers & position.byColor[Us];
+    }
+    return info;
+}
+
+inline CheckInfo checkInfo(const Position &position) {
+    return (position.turn == White) ? checkInfo<White>(position) : checkInfo<Black>(position);
+}
+
+// Shift a bitboard one rank towards the opponent's side of the board
+template<Color Us>
+constexpr Bitboard forward(Bitboard bitboard) { return (Us == White) ? north(bitboard) : south(bitboard); }
+
+/*
+An en passant capture removes two pawns from the same rank, which can expose the king along that rank in a way the pin masks do not cover,
+so legal generation plays it out on the occupancy and looks for attacks on the king instead.
+*/
+template<Color Us>
+bool enPassantIsLegal(const Position &position, const GenerationMasks &masks, Square fromSquare) {
+    if (!masks.legal)
+        return true;
+    Bitboard captured = position.enPassant;
+    Bitboard occupancy = (position.allPieces ^ BITBOARD(fromSquare) ^ captured) | forward<Us>(captured);
+    Bitboard attackers = attackersTo<~Us>(position, masks.king, occupancy) & ~captured;
+    if (attackers)
+        STATS_INC(StatEnPassantRejections);
+    return !attackers;
+}
+
+/*
+Pawn moves are generated for every pawn at once by shifting the whole set of pawns, one shift per direction of movement.
+A pinned pawn may only move along the line through its king, which is the case exactly when it stands on the king's line
+running in the direction of the move, so pinned pawns join each shift only when they lie on the matching line.
+*/
+template<Color Us, typename Sink>
+bool generatePawnMoves(const Position &position, const GenerationMasks &masks, Sink &sink) {
+    TRACE_SCOPE("generatePawnMoves");
+    constexpr Bitboard doublePushRank = (Us == White) ? RANK_3 : RANK_6;
+    constexpr Bitboard promotionRank = (Us == White) ? RANK_8 : RANK_1;
+    // Offsets from origin to destination of an advance and of captures towards the h-file and the a-file
+    constexpr int up = (Us == White) ? 8 : -8;
+    constexpr int upEast = (Us == White) ? 7 : -9;
+    constexpr int upWest = (Us == White) ? 9 : -7;
+
+    Bitboard pawns = position.pieces[Us][Pawn];
+    Bitboard advancing = pawns & ~masks.pinned, capturingEast = advancing, capturingWest = advancing;
+    if (Bitboard pinned = pawns & masks.pinned) {
+        Bitboard diagonal = rays[NorthEast][masks.king] | rays[SouthWest][masks.king];
+        Bitboard antiDiagonal = rays[NorthWest][masks.king] | rays[SouthEast][masks.king];
+        advancing |= pinned & (rays[North][masks.king] | rays[South][masks.king]);
+        capturingEast |= pinned & ((Us == White) ? diagonal : antiDiagonal);
+        capturingWest |= pinned & ((Us == White) ? antiDiagonal : diagonal);
+    }
+
+    // Advances need empty squares, and a double advance is only possible from the starting rank through an empty third rank
+    Bitboard advances = forward<Us>(advancing) & ~position.allPieces;
+    Bitboard doubleAdvances = forward<Us>(advances & doublePushRank) & ~position.allPieces & masks.targets;
+    advances &= masks.targets;
+    Bitboard eastCaptures = ((Us == White) ? northeast(capturingEast) : southeast(capturingEast)) & position.byColor[~Us] & masks.targets;
+    Bitboard westCaptures = ((Us == White) ? northwest(capturingWest) : southwest(capturingWest)) & position.byColor[~Us] & masks.targets;
+    STATS_ADD(StatPawnMoves, COUNT_BITS(advances) + COUNT_BITS(doubleAdvances) + COUNT_BITS(eastCaptures) + COUNT_BITS(westCaptures));
+
+    if (!sink.addShiftedPromotions(advances & promotionRank, up, false) || !sink.addShiftedPromotions(eastCaptures & promotionRank, upEast, true) ||
+        !sink.addShiftedPromotions(westCaptures & promotionRank, upWest, true))
+        return false;
+    if (!sink.addShifted(advances & ~promotionRank, up, Move::Quiet) || !sink.addShifted(doubleAdvances, 2 * up, Move::DoublePawnPush) ||
+        !sink.addShifted(eastCaptures & ~promotionRank, upEast, Move::Capture) || !sink.addShifted(westCaptures & ~promotionRank, upWest, Move::Capture))
+        return false;
+
+    // Add en passant for the pawns beside the one that has just made a double push, at most two of them
+    for (Bitboard fromSquares = (east(position.enPassant) | west(position.enPassant)) & pawns; fromSquares;) {
+        Square fromSquare = static_cast<Square>(POP_LSB(fromSquares));
+        if (enPassantIsLegal<Us>(position, masks, fromSquare) &&
+            !sink.add(Move(fromSquare, static_cast<Square>(GET_LSB(forward<Us>(position.enPassant))), Move::EnPassant)))
+            return false;
+    }
+    return true;
+}
+
+// Squares a knight, bishop, rook or queen on a square attacks
+template<PieceType Type>
+Bitboard pieceAttacks(Square square, Bitboard occupancy) {
+    if (Type == Knight)
+        return knightAttacks[square];
+    if (Type == Bishop)
+        return bishopAttacks(square, occupancy);
+    if (Type == Rook)
+        return rookAttacks(square, occupancy);
+    return queenAttacks(square, occupancy);
+}
+
+template<Color Us, PieceType Type, typename Sink>
+bool generatePieceMoves(const Position &position, const GenerationMasks &masks, Sink &sink) {
+#ifdef ENGINE_TRACE
+    static const char *const traceNames[] = { "", "generateKnightMoves", "generateBishopMoves", "generateRookMoves", "generateQueenMoves" };
+#endif
+    TRACE_SCOPE(traceNames[Type]);
+    for (Bitboard fromSquares = position.pieces[Us][Type]; fromSquares;) {
+        Square fromSquare = static_cast<Square>(POP_LSB(fromSquares));
+        // Look up the squares reachable before hitting a blocker, keeping pinned pieces on the line through the king
+        Bitboard toSquares = pieceAttacks<Type>(fromSquare, position.allPieces) & masks.targets;
+        if (BITBOARD(fromSquare) & masks.pinned)
+            toSquares &= lineSquares[masks.king][fromSquare];
+        STATS_ADD(static_cast<StatCounter>(StatPawnMoves + Type), COUNT_BITS(toSquares));
+
+        if (!sink.add(fromSquare, toSquares & ~position.byColor[~Us], Move::Quiet) || !sink.add(fromSquare, toSquares & position.byColor[~Us], Move::Capture))
+            return false;
+    }
+    return true;
+}
+
+template<Color Us, typename Sink>
+bool generateKingMoves(const Position &position, const GenerationMasks &masks, Sink &sink) {
+    TRACE_SCOPE("generateKingMoves");
+    if (!position.pieces[Us][King])
+        return true;
+
+    Bitboard toSquares = kingAttacks[masks.king] & ~position.byColor[Us] & ~masks.kingDanger;
+    STATS_ADD(StatKingMoves, COUNT_BITS(toSquares));
+    if (!sink.add(masks.king, toSquares & ~position.byColor[~Us], Move::Quiet) || !sink.add(masks.king, toSquares & position.byColor[~Us], Move::Capture))
+        return false;
+
+    /*
+    Castling requires the squares between the king and rook to be empty,
+    and the king may not castle out of, through or into check.
+    */
+    constexpr Bitboard kingSideBetween = (Us == White) ? 0x6ULL : 0x600000000000000ULL;
+    constexpr Bitboard queenSideBetween = (Us == White) ? 0x70ULL : 0x7000000000000000ULL;
+    constexpr Bitboard kingSidePath = (Us == White) ? 0xEULL : 0xE00000000000000ULL;
+    constexpr Bitboard queenSidePath = (Us == White) ? 0x38ULL : 0x3800000000000000ULL;
+    bool kingCastle = (Us == White) ? position.whiteKingCastle : position.blackKingCastle;
+    bool queenCastle = (Us == White) ? position.whiteQueenCastle : position.blackQueenCastle;
+    if (kingCastle && !(position.allPieces & kingSideBetween) && !(masks.kingDanger & kingSidePath) &&
+        !sink.add(Move(masks.king, (Us == White) ? Square::g1 : Square::g8, Move::KingCastle)))
+        return false;
+    if (queenCastle && !(position.allPieces & queenSideBetween) && !(masks.kingDanger & queenSidePath) &&
+        !sink.add(Move(masks.king, (Us == White) ? Square::c1 : Square::c8, Move::QueenCastle)))
+        return false;
+    return true;
+}
+
+/*
+Whether a move could have come from pseudo-legal generation in this position, checked from the move alone:
+one of our pieces stands on the origin, the move type fits that piece and the squares, and nothing blocks the way.
+*/
+template<Color Us>
+bool isPseudoLegal(const Position &position, Move move) {
+    constexpr Bitboard doublePushRank = (Us == White) ? RANK_3 : RANK_6;
+    constexpr Bitboard promotionRank = (Us == White) ? RANK_8 : RANK_1;
+    Square fromSquare = move.getFromSquare(), toSquare = move.getToSquare();
+    Bitboard from = BITBOARD(fromSquare), to = BITBOARD(toSquare);
+    Move::MoveType moveType = move.getMoveType();
+    if (move.isNull() || !(position.byColor[Us] & from))
+        return false;
+
+    // Quiet moves need an empty destination and captures an enemy piece there, except en passant
+    if (moveType != Move::EnPassant && (move.isCapture() ? !(position.byColor[~Us] & to) : (position.allPieces & to)))
+        return false;
+
+    PieceType type = position.pieceAt(fromSquare);
+    if (type == Pawn) {
+        if (move.isPromotion() != static_cast<bool>(to & promotionRank))
+            return false;
+        switch (moveType) {
+            case Move::EnPassant:
+                return ((east(from) | west(from)) & position.enPassant) && to == forward<Us>(position.enPassant);
+            case Move::DoublePawnPush:
+                return (pawnAdvances[Us][fromSquare] & doublePushRank & ~position.allPieces) && to == forward<Us>(forward<Us>(from));
+            case Move::Quiet: case Move::KnightPromotion: case Move::BishopPromotion: case Move::RookPromotion: case Move::QueenPromotion:
+                return pawnAdvances[Us][fromSquare] & to;
+            case Move::Capture: case Move::KnightPromotionCapture: case Move::BishopPromotionCapture:
+            case Move::RookPromotionCapture: case Move::QueenPromotionCapture:
+                return pawnCaptures[Us][fromSquare] & to;
+            default:
+                return false;
+        }
+    }
+
+    if (type == King && (moveType == Move::KingCastle || moveType == Move::QueenCastle)) {
+        bool kingSide = moveType == Move::KingCastle;
+        bool right = (Us == White) ? (kingSide ? position.whiteKingCastle : position.whiteQueenCastle)
+                                   : (kingSide ? position.blackKingCastle : position.blackQueenCastle);
+        Square kingFrom = (Us == White) ? Square::e1 : Square::e8;
+        Square kingTo = (Us == White) ? (kingSide ? Square::g1 : Square::c1) : (kingSide ? Square::g8 : Square::c8);
+        Square rookFrom = (Us == White) ? (kingSide ? Square::h1 : Square::a1) : (kingSide ? Square::h8 : Square::a8);
+        return right && fromSquare == kingFrom && toSquare == kingTo && (position.pieces[Us][Rook] & BITBOARD(rookFrom)) &&
+               !(betweenSquares[kingFrom][rookFrom] & position.allPieces);
+    }
+
+    if (moveType != Move::Quiet && moveType != Move::Capture)
+        return false;
+    switch (type) {
+        case Knight: return pieceAttacks<Knight>(fromSquare, position.allPieces) & to;
+        case Bishop: return pieceAttacks<Bishop>(fromSquare, position.allPieces) & to;
+        case Rook: return pieceAttacks<Rook>(fromSquare, position.allPieces) & to;
+        case Queen: return pieceAttacks<Queen>(fromSquare, position.allPieces) & to;
+        default: return kingAttacks[fromSquare] & to;
+    }
+}
+
+/*
+Whether a pseudo-legal move keeps our king safe, applying the same masks as legal generation:
+the king avoids attacked squares, other pieces must answer a check and pinned pieces stay on their line.
+*/
+template<Color Us>
+bool isLegal(const Position &position, const GenerationMasks &masks, Move move) {
+    if (!masks.legal)
+        return true;
+    Square fromSquare = move.getFromSquare();
+    Bitboard to = BITBOARD(move.getToSquare());
+    Move::MoveType moveType = move.getMoveType();
+
+    if (fromSquare == masks.king) {
+        // The path of a castling king includes its own square, so castling out of check is ruled out too
+        constexpr Bitboard kingSidePath = (Us == White) ? 0xEULL : 0xE00000000000000ULL;
+        constexpr Bitboard queenSidePath = (Us == White) ? 0x38ULL : 0x3800000000000000ULL;
+        if (moveType == Move::KingCastle || moveType == Move::QueenCastle)
+            return !(masks.kingDanger & ((moveType == Move::KingCastle) ? kingSidePath : queenSidePath));
+        return !(masks.kingDanger & to);
+    }
+    if (moveType == Move::EnPassant)
+        return enPassantIsLegal<Us>(position, masks, fromSquare);
+    if (!(masks.targets & to))
+        return false;
+    return !(BITBOARD(fromSquare) & masks.pinned) || (lineSquares[masks.king][fromSquare] & to);
+}
+
+// Generate moves piece type by piece type, returning false if the sink stopped generation
+template<Color Us, typename Sink>
+bool generateMoves(const Position &position, const GenerationMasks &masks, Sink &sink) {
+    // With no target squares, as in double check, only the king can move
+    if (masks.targets && !(generatePawnMoves<Us>(position, masks, sink) && generatePieceMoves<Us, Knight>(position, masks, sink) &&
+                           generatePieceMoves<Us, Bishop>(position, masks, sink) && generatePieceMoves<Us, Rook>(position, masks, sink) &&
+                           generatePieceMoves<Us, Queen>(position, masks, sink)))
+        return false;
+    return generateKingMoves<Us>(position, masks, sink);
+}
+
+// Work out the legality masks of the side to move
+inline GenerationMasks legalMasks(const Position &position) {
+    return (position.turn == White) ? legalMasks<White>(position) : legalMasks<Black>(position);
+}
+
+// Feed every legal move of the side to move to a sink, given the masks from legalMasks
+template<typename Sink>
+bool generateLegal(const Position &position, const GenerationMasks &masks, Sink &sink) {
+    return (position.turn == White) ? generateMoves<White>(position, masks, sink) : generateMoves<Black>(position, masks, sink);
+}
+
+// Feed every legal move of the side to move to a sink
+template<typename Sink>
+bool generateLegal(const Position &position, Sink &sink) {
+    return generateLegal(position, legalMasks(position), sink);
+}
+
+// Feed every pseudo-legal move of the side to move to a sink, including moves that leave the king in check
+template<typename Sink>
+bool generatePseudoLegal(const Position &position, Sink &sink) {
+    return (position.turn == White) ? generateMoves<White>(position, pseudoLegalMasks<White>(position), sink)
+                                    : generateMoves<Black>(position, pseudoLegalMasks<Black>(position), sink);
+}
+
+#endif // MOVE_GENERATION_H
@@ -0,0 +1,168 @@
+#include "position.h"
+#include <sstream>
+#include "bitboard.h"
+#include "zobrist.h"
+
+// XOR of the keys of every castling right still held
+static uint64_t castlingKey(const Position &position) {
+    return (position.whiteKingCastle ? zobrist.castling[0] : 0ULL) ^ (position.whiteQueenCastle ? zobrist.castling[1] : 0ULL) ^
+           (position.blackKingCastle ? zobrist.castling[2] : 0ULL) ^ (position.blackQueenCastle ? zobrist.castling[3] : 0ULL);
+}
+
+// Key of the en passant state, which only depends on the file of the pawn that can be captured
+static uint64_t enPassantKey(Bitboard enPassant) {
+    return enPassant ? zobrist.enPassant[GET_LSB(enPassant) % 8] : 0ULL;
+}
+
+uint64_t Position::computeKey() const {
+    uint64_t result = 0ULL;
+    for (int color = White; color <= Black; color++) {
+        for (int type = Pawn; type <= King; type++) {
+            Bitboard bitboard = pieces[color][type];
+            while (bitboard)
+                result ^= zobrist.pieces[color][type][POP_LSB(bitboard)];
+        }
+    }
+    result ^= castlingKey(*this) ^ enPassantKey(enPassant);
+    if (turn == Black)
+        result ^= zobrist.side;
+    return result;
+}
+
+// Replace the current position with the one described by a FEN string
+bool Position::loadFEN(const std::string &fen) {
+    std::istringstream stream(fen);
+    std::string placement, activeColor, castling, enPassantTarget;
+    if (!(stream >> placement >> activeColor >> castling >> enPassantTarget))
+        return false;
+
+    for (int color = White; color <= Black; color++)
+        for (int type = Pawn; type <= King; type++)
+            pieces[color][type] = 0ULL;
+    byColor[White] = byColor[Black] = allPieces = 0ULL;
+
+    // Ranks are listed from 8 down to 1 and files from a to h, which is the reverse of the square indices
+    const std::string pieceLetters = "PNBRQKpnbrqk";
+    int rank = 7, file = 0;
+    for (char c : placement) {
+        if (c == '/') {
+            if (file != 8 || rank == 0)
+                return false;
+            rank--;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            size_t piece = pieceLetters.find(c);
+            if (piece == std::string::npos || file > 7)
+                return false;
+            putPiece(static_cast<Color>(piece / 6), static_cast<PieceType>(piece % 6), static_cast<Square>(rank * 8 + (7 - file)));
+            file++;
+        }
+        if (file > 8)
+            return false;
+    }
+    if (rank != 0 || file != 8)
+        return false;
+
+    if (activeColor != "w" && activeColor != "b")
+        return false;
+    turn = (activeColor == "w") ? White : Black;
+
+    whiteKingCastle = castling.find('K') != std::string::npos;
+    whiteQueenCastle = castling.find('Q') != std::string::npos;
+    blackKingCastle = castling.find('k') != std::string::npos;
+    blackQueenCastle = castling.find('q') != std::string::npos;
+
+    // FEN names the square behind the pawn, while the board tracks the pawn that made the double push
+    enPassant = 0ULL;
+    if (enPassantTarget != "-") {
+        if (enPassantTarget.size() != 2 || enPassantTarget[0] < 'a' || enPassantTarget[0] > 'h' || (enPassantTarget[1] != '3' && enPassantTarget[1] != '6'))
+            return false;
+        Bitboard target = BITBOARD((enPassantTarget[1] - '1') * 8 + ('h' - enPassantTarget[0]));
+        Bitboard pawn = (turn == White) ? south(target) : north(target);
+        // Only kept when a pawn can actually capture, matching the positions reached by play
+        enPassant = ((east(pawn) | west(pawn)) & pieces[turn][PieceType::Pawn]) ? pawn : 0ULL;
+    }
+
+    // The move counters are optional and default to the start of a game
+    int halfmoves = 0, fullmoves = 1;
+    stream >> halfmoves >> fullmoves;
+    halfmoveClock = static_cast<uint16_t>(halfmoves);
+    fullmoveNumber = static_cast<uint16_t>(fullmoves);
+
+    key = computeKey();
+    return true;
+}
+
+// Return the type of piece present at a given square
+PieceType Position::pieceAt(Square square) const {
+    Bitboard bit = BITBOARD(square);
+    if (!(allPieces & bit))
+        return PieceType::None;
+
+    // Both colors share each type's slot, so one test per type suffices
+    for (int type = Pawn; type < King; type++)
+        if ((pieces[White][type] | pieces[Black][type]) & bit)
+            return static_cast<PieceType>(type);
+    return PieceType::King;
+}
+
+// Pass board control to the opponent
+void Position::passTurn() {
+    turn = ~turn;
+    key ^= zobrist.side;
+}
+
+// Play a move on the position
+void Position::makeMove(Move move) {
+    // Get move information
+    Square fromSquare = move.getFromSquare(), toSquare = move.getToSquare();
+    Move::MoveType moveType = move.getMoveType();
+    Color us = turn, them = ~turn;
+    PieceType fromPiece = pieceAt(fromSquare);
+
+    // Remove the old en passant and castling state from the key; the new state is added back at the end
+    key ^= castlingKey(*this) ^ enPassantKey(enPassant);
+
+    // Captures and pawn moves are irreversible and restart the fifty-move count
+    halfmoveClock = (move.isCapture() || fromPiece == PieceType::Pawn) ? 0 : halfmoveClock + 1;
+    fullmoveNumber += us;
+
+    // Erase pieces at capture positions; an en passant capture takes the pawn that made the double push
+    if (moveType == Move::EnPassant)
+        removePiece(them, PieceType::Pawn, static_cast<Square>(GET_LSB(enPassant)));
+    else if (move.isCapture())
+        removePiece(them, pieceAt(toSquare), toSquare);
+
+    // Move piece on its board
+    movePiece(us, fromPiece, fromSquare, toSquare);
+
+    // Perform promotions, whose two low type bits select the piece from knight to queen
+    if (move.isPromotion()) {
+        removePiece(us, PieceType::Pawn, toSquare);
+        putPiece(us, static_cast<PieceType>(PieceType::Knight + (moveType & 0x3)), toSquare);
+    }
+
+    // Handle rook movement for castling
+    if (moveType == Move::KingCastle)
+        movePiece(us, PieceType::Rook, (us == White) ? Square::h1 : Square::h8, (us == White) ? Square::f1 : Square::f8);
+    else if (moveType == Move::QueenCastle)
+        movePiece(us, PieceType::Rook, (us == White) ? Square::a1 : Square::a8, (us == White) ? Square::d1 : Square::d8);
+
+    // Store en passant squares only when an enemy pawn stands ready to capture, so that equal positions share a key
+    Bitboard doublePush = (moveType == Move::DoublePawnPush) ? BITBOARD(toSquare) : 0ULL;
+    enPassant = ((east(doublePush) | west(doublePush)) & pieces[them][PieceType::Pawn]) ? doublePush : 0ULL;
+
+    // Castling rights are lost once anything moves from or to the king's or a rook's starting square
+    Bitboard touched = BITBOARD(fromSquare) | BITBOARD(toSquare);
+    whiteKingCastle &= !(touched & (BITBOARD(Square::e1) | BITBOARD(Square::h1)));
+    whiteQueenCastle &= !(touched & (BITBOARD(Square::e1) | BITBOARD(Square::a1)));
+    blackKingCastle &= !(touched & (BITBOARD(Square::e8) | BITBOARD(Square::h8)));
+    blackQueenCastle &= !(touched & (BITBOARD(Square::e8) | BITBOARD(Square::a8)));
+
+    key ^= castlingKey(*this) ^ enPassantKey(enPassant);
+
+    // Transfer control of the board to the opponent
+    passTurn();
+}
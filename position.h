@@ -0,0 +1,84 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include "bitboard.h"
+#include "move.h"
+#include "types.h"
+#include "zobrist.h"
+
+/*
+The complete state of a position, without any record of how it was reached.
+Position is plain data: it can be copied with memcpy, handed to another thread or queued without touching the heap.
+Making a move on a copy (copy-make) is the cheapest way to explore a position without needing to undo anything.
+The game history needed to take moves back lives in Chessboard, which builds on this struct.
+*/
+struct Position {
+    /*
+    Bitboards representing piece locations, indexed by color and then piece type.
+    byColor holds the union of each side's pieces and allPieces the union of both sides.
+    */
+    Bitboard pieces[2][6];
+    Bitboard byColor[2];
+    Bitboard allPieces;
+
+    // Variable to store double pawn moves that could enable an en passant
+    Bitboard enPassant;
+
+    // Zobrist hash of everything above along with the side to move and castling rights
+    uint64_t key;
+
+    // Plies since the last capture or pawn move, and the number of the current full move
+    uint16_t halfmoveClock;
+    uint16_t fullmoveNumber;
+
+    // Active player
+    Color turn;
+
+    // Used to track castling rights for each side
+    bool whiteQueenCastle, whiteKingCastle, blackQueenCastle, blackKingCastle;
+
+    // Set up the position described by a FEN string, returning false if it is malformed
+    bool loadFEN(const std::string &fen);
+    // Compute the Zobrist key from scratch
+    uint64_t computeKey() const;
+
+    // Square info
+    // Returns the piece type at a given square
+    PieceType pieceAt(Square square) const;
+
+    // Piece placement helpers, keeping the piece, color and occupancy bitboards and the key in sync without branching
+    void putPiece(Color color, PieceType type, Square square) {
+        Bitboard bit = BITBOARD(square);
+        pieces[color][type] |= bit;
+        byColor[color] |= bit;
+        allPieces |= bit;
+        key ^= zobrist.pieces[color][type][square];
+    }
+    void removePiece(Color color, PieceType type, Square square) {
+        Bitboard bit = BITBOARD(square);
+        pieces[color][type] &= ~bit;
+        byColor[color] &= ~bit;
+        allPieces &= ~bit;
+        key ^= zobrist.pieces[color][type][square];
+    }
+    void movePiece(Color color, PieceType type, Square fromSquare, Square toSquare) {
+        Bitboard fromTo = BITBOARD(fromSquare) | BITBOARD(toSquare);
+        pieces[color][type] ^= fromTo;
+        byColor[color] ^= fromTo;
+        allPieces ^= fromTo;
+        key ^= zobrist.pieces[color][type][fromSquare] ^ zobrist.pieces[color][type][toSquare];
+    }
+
+    // Board manipulation
+    // Play a move without keeping any information to undo it
+    void makeMove(Move move);
+    // Give control of the board to the opponent
+    void passTurn();
+};
+
+static_assert(std::is_trivially_copyable<Position>::value, "Position must stay plain data so that it can be copied freely");
+
+#endif // POSITION_H
@@ -0,0 +1,317 @@
+#include "position_batch.h"
+#include <cstring>
+#include "attack_maps.h"
+#include "attacks.h"
+
+void PositionBatch::reserve(size_t count) {
+    for (int color = White; color <= Black; color++)
+        for (int type = Pawn; type <= King; type++)
+            pieces[color][type].reserve(count);
+    enPassant.reserve(count);
+    flags.reserve(count);
+}
+
+void PositionBatch::clear() {
+    for (int color = White; color <= Black; color++)
+        for (int type = Pawn; type <= King; type++)
+            pieces[color][type].clear();
+    enPassant.clear();
+    flags.clear();
+}
+
+void PositionBatch::push_back(const Position &position) {
+    for (int color = White; color <= Black; color++)
+        for (int type = Pawn; type <= King; type++)
+            pieces[color][type].push_back(position.pieces[color][type]);
+    enPassant.push_back(position.enPassant);
+    const uint64_t none = 0;
+    flags.push_back((position.turn == Black ? static_cast<uint64_t>(BlackToMove) : none) |
+                    (position.whiteKingCastle ? static_cast<uint64_t>(WhiteKingCastle) : none) |
+                    (position.whiteQueenCastle ? static_cast<uint64_t>(WhiteQueenCastle) : none) |
+                    (position.blackKingCastle ? static_cast<uint64_t>(BlackKingCastle) : none) |
+                    (position.blackQueenCastle ? static_cast<uint64_t>(BlackQueenCastle) : none));
+}
+
+Position PositionBatch::get(size_t index) const {
+    Position position = {};
+    for (int color = White; color <= Black; color++) {
+        for (int type = Pawn; type <= King; type++) {
+            position.pieces[color][type] = pieces[color][type][index];
+            position.byColor[color] |= pieces[color][type][index];
+        }
+    }
+    position.allPieces = position.byColor[White] | position.byColor[Black];
+    position.enPassant = enPassant[index];
+    position.turn = (flags[index] & BlackToMove) ? Black : White;
+    position.whiteKingCastle = flags[index] & WhiteKingCastle;
+    position.whiteQueenCastle = flags[index] & WhiteQueenCastle;
+    position.blackKingCastle = flags[index] & BlackKingCastle;
+    position.blackQueenCastle = flags[index] & BlackQueenCastle;
+    position.fullmoveNumber = 1;
+    position.key = position.computeKey();
+    return position;
+}
+
+/*
+The kernel is written once over a lane type: a single Bitboard for the scalar path,
+or a GCC vector of four bitboards from consecutive positions for the AVX2 path.
+*/
+typedef Bitboard BitboardLanes __attribute__((vector_size(32)));
+typedef uint8_t ByteLanes __attribute__((vector_size(32)));
+
+// All ones where a bitboard is empty, all zeros elsewhere
+ATTACK_MAPS_INLINE Bitboard zeroMask(Bitboard bitboard) { return -static_cast<Bitboard>(bitboard == 0); }
+ATTACK_MAPS_INLINE BitboardLanes zeroMask(BitboardLanes bitboards) { return (BitboardLanes)(bitboards == 0); }
+
+// Mirror the board vertically by reversing the order of the ranks
+ATTACK_MAPS_INLINE Bitboard flipVertical(Bitboard bitboard) { return __builtin_bswap64(bitboard); }
+ATTACK_MAPS_INLINE BitboardLanes flipVertical(BitboardLanes bitboards) {
+    // Both compilers reverse the bytes within each lane, through their own spelling of a constant shuffle
+#ifdef __clang__
+    return (BitboardLanes)__builtin_shufflevector((ByteLanes)bitboards, (ByteLanes)bitboards, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                                  23, 22, 21, 20, 19, 18, 17, 16, 31, 30, 29, 28, 27, 26, 25, 24);
+#else
+    const ByteLanes order = { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                              23, 22, 21, 20, 19, 18, 17, 16, 31, 30, 29, 28, 27, 26, 25, 24 };
+    return (BitboardLanes)__builtin_shuffle((ByteLanes)bitboards, order);
+#endif
+}
+
+// Population count of every lane, using shifts and adds only since AVX2 has no vector popcount or 64-bit multiply
+template<typename Lanes>
+ATTACK_MAPS_INLINE Lanes populationCount(Lanes bitboards) {
+    bitboards = bitboards - ((bitboards >> 1) & 0x5555555555555555ULL);
+    bitboards = (bitboards & 0x3333333333333333ULL) + ((bitboards >> 2) & 0x3333333333333333ULL);
+    bitboards = (bitboards + (bitboards >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    bitboards += bitboards >> 8;
+    bitboards += bitboards >> 16;
+    bitboards += bitboards >> 32;
+    return bitboards & 0x7F;
+}
+
+template<typename Lanes>
+ATTACK_MAPS_INLINE Lanes select(Lanes mask, Lanes ifSet, Lanes ifClear) { return (ifSet & mask) | (ifClear & ~mask); }
+
+template<typename Lanes>
+ATTACK_MAPS_INLINE Lanes load(const Bitboard *source) {
+    Lanes lanes;
+    std::memcpy(&lanes, source, sizeof(lanes));
+    return lanes;
+}
+
+template<typename Lanes>
+ATTACK_MAPS_INLINE void store(Bitboard *destination, Lanes lanes) { std::memcpy(destination, &lanes, sizeof(lanes)); }
+
+template<typename Lanes>
+ATTACK_MAPS_INLINE Lanes slidingAttacks(Lanes orthogonalSliders, Lanes diagonalSliders, Lanes empty) {
+    return occludedAttacks<North>(orthogonalSliders, empty) | occludedAttacks<East>(orthogonalSliders, empty) |
+           occludedAttacks<South>(orthogonalSliders, empty) | occludedAttacks<West>(orthogonalSliders, empty) |
+           occludedAttacks<NorthEast>(diagonalSliders, empty) | occludedAttacks<NorthWest>(diagonalSliders, empty) |
+           occludedAttacks<SouthWest>(diagonalSliders, empty) | occludedAttacks<SouthEast>(diagonalSliders, empty);
+}
+
+template<typename Lanes>
+ATTACK_MAPS_INLINE Lanes kingAttackLanes(Lanes kings) {
+    return step<North>(kings) | step<East>(kings) | step<South>(kings) | step<West>(kings) |
+           step<NorthEast>(kings) | step<NorthWest>(kings) | step<SouthWest>(kings) | step<SouthEast>(kings);
+}
+
+// The eight knight jumps, each made of one orthogonal and one diagonal step
+template<typename Lanes>
+ATTACK_MAPS_INLINE void knightJumps(Lanes knights, Lanes jumps[8]) {
+    jumps[0] = step<North>(step<NorthEast>(knights));
+    jumps[1] = step<North>(step<NorthWest>(knights));
+    jumps[2] = step<South>(step<SouthEast>(knights));
+    jumps[3] = step<South>(step<SouthWest>(knights));
+    jumps[4] = step<East>(step<NorthEast>(knights));
+    jumps[5] = step<East>(step<SouthEast>(knights));
+    jumps[6] = step<West>(step<NorthWest>(knights));
+    jumps[7] = step<West>(step<SouthWest>(knights));
+}
+
+// Opposite directions share an axis: 0 is vertical, 1 horizontal, 2 the northeast diagonal and 3 the northwest diagonal
+constexpr int oppositeDirection(int direction) { return (direction < NorthEast) ? (direction + 2) % 4 : NorthEast + (direction - NorthEast + 2) % 4; }
+constexpr int axisOf(int direction) { return (direction < NorthEast) ? direction % 2 : 2 + (direction - NorthEast) % 2; }
+
+/*
+Look outwards from the king in one direction.
+The ray reaches the first piece in the way; if that piece is an enemy slider moving along this line, the ray is a check,
+and if it is one of our pieces that an enemy slider also reaches from the far side, that piece is pinned to the axis.
+*/
+template<int Direction, typename Lanes>
+ATTACK_MAPS_INLINE void scanFromKing(Lanes king, Lanes empty, Lanes ourPieces, Lanes theirSliders, Lanes &checkRays, Lanes pinned[4]) {
+    Lanes ray = occludedAttacks<Direction>(king, empty);
+    checkRays |= ray & ~zeroMask(ray & theirSliders);
+    pinned[axisOf(Direction)] |= ray & ourPieces & occludedAttacks<oppositeDirection(Direction)>(theirSliders, empty);
+}
+
+// Count the moves of our sliders in one direction; every reachable square is reached by exactly one slider, the nearest behind it
+template<int Direction, typename Lanes>
+ATTACK_MAPS_INLINE Lanes countSliderMoves(Lanes sliders, Lanes empty, const Lanes pinned[4], Lanes allPinned, Lanes targets) {
+    Lanes movers = sliders & (~allPinned | pinned[axisOf(Direction)]);
+    return populationCount(occludedAttacks<Direction>(movers, empty) & targets);
+}
+
+// Count pawn moves landing on a set of squares, with each promotion counting once per piece it can become
+template<typename Lanes>
+ATTACK_MAPS_INLINE Lanes countPawnMoves(Lanes destinations) {
+    return populationCount(destinations & ~RANK_8) + (populationCount(destinations & RANK_8) << 2);
+}
+
+/*
+Analyze the positions starting at an index, as many as there are lanes.
+Every position is viewed from the side to move, mirrored vertically when black is to move,
+so that the kernel only ever handles white pawns and white castling.
+En passant is left to countEnPassantMoves.
+*/
+template<typename Lanes>
+ATTACK_MAPS_INLINE void analyzeLanes(const PositionBatch &batch, size_t first, BatchAnalysis &analysis) {
+    const Lanes flags = load<Lanes>(&batch.flags[first]);
+    const Lanes blackToMove = ~zeroMask(flags & static_cast<uint64_t>(PositionBatch::BlackToMove));
+
+    Lanes us[6], them[6];
+    for (int type = Pawn; type <= King; type++) {
+        Lanes white = load<Lanes>(&batch.pieces[White][type][first]), black = load<Lanes>(&batch.pieces[Black][type][first]);
+        us[type] = select(blackToMove, flipVertical(black), white);
+        them[type] = select(blackToMove, flipVertical(white), black);
+    }
+    const Lanes kingSideRight = ~zeroMask(flags & ((blackToMove & static_cast<uint64_t>(PositionBatch::BlackKingCastle)) |
+                                                   (~blackToMove & static_cast<uint64_t>(PositionBatch::WhiteKingCastle))));
+    const Lanes queenSideRight = ~zeroMask(flags & ((blackToMove & static_cast<uint64_t>(PositionBatch::BlackQueenCastle)) |
+                                                    (~blackToMove & static_cast<uint64_t>(PositionBatch::WhiteQueenCastle))));
+
+    const Lanes ourPieces = us[Pawn] | us[Knight] | us[Bishop] | us[Rook] | us[Queen] | us[King];
+    const Lanes theirPieces = them[Pawn] | them[Knight] | them[Bishop] | them[Rook] | them[Queen] | them[King];
+    const Lanes empty = ~(ourPieces | theirPieces);
+    const Lanes king = us[King];
+    const Lanes ourOrthogonal = us[Rook] | us[Queen], ourDiagonal = us[Bishop] | us[Queen];
+    const Lanes theirOrthogonal = them[Rook] | them[Queen], theirDiagonal = them[Bishop] | them[Queen];
+
+    // Attack maps; the king may not step back along a checking ray either, so its escapes are tested with it lifted off the board
+    Lanes ourKnightJumps[8], theirKnightJumps[8];
+    knightJumps(us[Knight], ourKnightJumps);
+    knightJumps(them[Knight], theirKnightJumps);
+    Lanes ourLeaperAttacks = step<NorthEast>(us[Pawn]) | step<NorthWest>(us[Pawn]) | kingAttackLanes(king);
+    Lanes theirLeaperAttacks = step<SouthEast>(them[Pawn]) | step<SouthWest>(them[Pawn]) | kingAttackLanes(them[King]);
+    for (int jump = 0; jump < 8; jump++) {
+        ourLeaperAttacks |= ourKnightJumps[jump];
+        theirLeaperAttacks |= theirKnightJumps[jump];
+    }
+    const Lanes ourAttacks = ourLeaperAttacks | slidingAttacks(ourOrthogonal, ourDiagonal, empty);
+    const Lanes theirAttacks = theirLeaperAttacks | slidingAttacks(theirOrthogonal, theirDiagonal, empty);
+    const Lanes theirAttacksThroughKing = theirLeaperAttacks | slidingAttacks(theirOrthogonal, theirDiagonal, empty | king);
+
+    // Checks and pins along the eight rays from the king
+    Lanes checkRays = king & 0, pinned[4] = { checkRays, checkRays, checkRays, checkRays };
+    scanFromKing<North>(king, empty, ourPieces, theirOrthogonal, checkRays, pinned);
+    scanFromKing<East>(king, empty, ourPieces, theirOrthogonal, checkRays, pinned);
+    scanFromKing<South>(king, empty, ourPieces, theirOrthogonal, checkRays, pinned);
+    scanFromKing<West>(king, empty, ourPieces, theirOrthogonal, checkRays, pinned);
+    scanFromKing<NorthEast>(king, empty, ourPieces, theirDiagonal, checkRays, pinned);
+    scanFromKing<NorthWest>(king, empty, ourPieces, theirDiagonal, checkRays, pinned);
+    scanFromKing<SouthWest>(king, empty, ourPieces, theirDiagonal, checkRays, pinned);
+    scanFromKing<SouthEast>(king, empty, ourPieces, theirDiagonal, checkRays, pinned);
+    const Lanes allPinned = pinned[0] | pinned[1] | pinned[2] | pinned[3];
+
+    // Out of check, a move must capture the single checker or block its ray; in double check only the king can move
+    Lanes kingJumps[8];
+    knightJumps(king, kingJumps);
+    Lanes checkMask = checkRays | ((step<NorthEast>(king) | step<NorthWest>(king)) & them[Pawn]);
+    for (int jump = 0; jump < 8; jump++)
+        checkMask |= kingJumps[jump] & them[Knight];
+    const Lanes checkers = checkMask & theirPieces;
+    const Lanes notInCheck = zeroMask(checkers);
+    const Lanes singleCheck = zeroMask(checkers & (checkers - 1)) & ~notInCheck;
+    const Lanes targets = ~ourPieces & (notInCheck | (singleCheck & checkMask));
+
+    Lanes count = populationCount(kingAttackLanes(king) & ~ourPieces & ~theirAttacksThroughKing);
+
+    // Pinned knights can never move, since a jump always leaves the pin line
+    Lanes freeKnightJumps[8];
+    knightJumps(us[Knight] & ~allPinned, freeKnightJumps);
+    for (int jump = 0; jump < 8; jump++)
+        count += populationCount(freeKnightJumps[jump] & targets);
+
+    count += countSliderMoves<North>(ourOrthogonal, empty, pinned, allPinned, targets);
+    count += countSliderMoves<East>(ourOrthogonal, empty, pinned, allPinned, targets);
+    count += countSliderMoves<South>(ourOrthogonal, empty, pinned, allPinned, targets);
+    count += countSliderMoves<West>(ourOrthogonal, empty, pinned, allPinned, targets);
+    count += countSliderMoves<NorthEast>(ourDiagonal, empty, pinned, allPinned, targets);
+    count += countSliderMoves<NorthWest>(ourDiagonal, empty, pinned, allPinned, targets);
+    count += countSliderMoves<SouthWest>(ourDiagonal, empty, pinned, allPinned, targets);
+    count += countSliderMoves<SouthEast>(ourDiagonal, empty, pinned, allPinned, targets);
+
+    // Pawns push along the vertical axis and capture along the diagonals
+    const Lanes singlePushes = step<North>(us[Pawn] & (~allPinned | pinned[0])) & empty;
+    const Lanes doublePushes = step<North>(singlePushes & RANK_3) & empty;
+    count += countPawnMoves(singlePushes & targets) + populationCount(doublePushes & targets);
+    count += countPawnMoves(step<NorthEast>(us[Pawn] & (~allPinned | pinned[2])) & theirPieces & targets);
+    count += countPawnMoves(step<NorthWest>(us[Pawn] & (~allPinned | pinned[3])) & theirPieces & targets);
+
+    // Castling needs the squares between king and rook empty, and the king's start, path and destination unattacked
+    const Bitboard kingSidePath = BITBOARD(Square::f1) | BITBOARD(Square::g1);
+    const Bitboard queenSidePath = BITBOARD(Square::b1) | BITBOARD(Square::c1) | BITBOARD(Square::d1);
+    const Bitboard kingSideSafe = BITBOARD(Square::e1) | BITBOARD(Square::f1) | BITBOARD(Square::g1);
+    const Bitboard queenSideSafe = BITBOARD(Square::e1) | BITBOARD(Square::d1) | BITBOARD(Square::c1);
+    count += kingSideRight & zeroMask(~empty & kingSidePath) & zeroMask(theirAttacks & kingSideSafe) & 1;
+    count += queenSideRight & zeroMask(~empty & queenSidePath) & zeroMask(theirAttacks & queenSideSafe) & 1;
+
+    store(&analysis.attacks[White][first], select(blackToMove, flipVertical(theirAttacks), ourAttacks));
+    store(&analysis.attacks[Black][first], select(blackToMove, flipVertical(ourAttacks), theirAttacks));
+    Bitboard counts[sizeof(Lanes) / sizeof(Bitboard)];
+    store(counts, count);
+    for (size_t lane = 0; lane < sizeof(Lanes) / sizeof(Bitboard); lane++)
+        analysis.legalMoveCounts[first + lane] = static_cast<uint32_t>(counts[lane]);
+}
+
+/*
+En passant captures are counted one position at a time, by playing the capture on the occupancy and looking for attacks on the king.
+They are rare, and taking two pawns off one rank can expose the king along that rank, which the pin scan cannot see.
+*/
+static uint32_t countEnPassantMoves(const Position &position) {
+    Color us = position.turn, them = ~us;
+    Square king = static_cast<Square>(GET_LSB(position.pieces[us][King]));
+    Bitboard captured = position.enPassant;
+    Bitboard toSquare = (us == White) ? north(captured) : south(captured);
+
+    uint32_t count = 0;
+    for (Bitboard capturers = (east(captured) | west(captured)) & position.pieces[us][Pawn]; capturers;) {
+        Bitboard occupancy = (position.allPieces ^ BITBOARD(POP_LSB(capturers)) ^ captured) | toSquare;
+        Bitboard attackers = (rookAttacks(king, occupancy) & (position.pieces[them][Rook] | position.pieces[them][Queen])) |
+                             (bishopAttacks(king, occupancy) & (position.pieces[them][Bishop] | position.pieces[them][Queen])) |
+                             (knightAttacks[king] & position.pieces[them][Knight]) | (pawnCaptures[us][king] & position.pieces[them][Pawn] & ~captured);
+        count += !attackers;
+    }
+    return count;
+}
+
+#ifdef ATTACK_MAPS_AVX2_AVAILABLE
+__attribute__((target("avx2")))
+static void analyzeBlocksAvx2(const PositionBatch &batch, size_t blocks, BatchAnalysis &analysis) {
+    for (size_t block = 0; block < blocks; block++)
+        analyzeLanes<BitboardLanes>(batch, block * (sizeof(BitboardLanes) / sizeof(Bitboard)), analysis);
+}
+#endif
+
+void analyzeBatch(const PositionBatch &batch, BatchAnalysis &analysis) {
+    size_t size = batch.size();
+    analysis.legalMoveCounts.resize(size);
+    analysis.attacks[White].resize(size);
+    analysis.attacks[Black].resize(size);
+
+    // Whole blocks of four go through the vector kernel when AVX2 is in use, and the rest through the scalar one
+    size_t first = 0;
+#ifdef ATTACK_MAPS_AVX2_AVAILABLE
+    if (attackMapBackend == Avx2AttackMaps) {
+        size_t blocks = size / (sizeof(BitboardLanes) / sizeof(Bitboard));
+        analyzeBlocksAvx2(batch, blocks, analysis);
+        first = blocks * (sizeof(BitboardLanes) / sizeof(Bitboard));
+    }
+#endif
+    for (size_t index = first; index < size; index++)
+        analyzeLanes<Bitboard>(batch, index, analysis);
+
+    for (size_t index = 0; index < size; index++)
+        if (batch.enPassant[index])
+            analysis.legalMoveCounts[index] += countEnPassantMoves(batch.get(index));
+}
@@ -0,0 +1,53 @@
+#ifndef POSITION_BATCH_H
+#define POSITION_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bitboard.h"
+#include "position.h"
+#include "types.h"
+
+/*
+Many independent positions stored field by field (structure of arrays), for bulk jobs such as labeling datasets.
+Each field of consecutive positions is contiguous, so a kernel can load the same bitboard of several positions into one vector
+and analyze them side by side; throughput in positions per second is what matters here, not the latency of one position.
+*/
+struct PositionBatch {
+    // Bit flags stored per position alongside the bitboards
+    enum Flags : uint64_t {
+        BlackToMove = 1,
+        WhiteKingCastle = 2,
+        WhiteQueenCastle = 4,
+        BlackKingCastle = 8,
+        BlackQueenCastle = 16
+    };
+
+    std::vector<Bitboard> pieces[2][6];
+    std::vector<Bitboard> enPassant;
+    std::vector<uint64_t> flags;
+
+    size_t size() const { return flags.size(); }
+    void reserve(size_t count);
+    void clear();
+    // Append a position to the end of the batch
+    void push_back(const Position &position);
+    // Rebuild the position stored at an index
+    Position get(size_t index) const;
+};
+
+// Per-position results of analyzing a batch
+struct BatchAnalysis {
+    std::vector<uint32_t> legalMoveCounts;
+    // Squares attacked by each side, indexed by color and then position
+    std::vector<Bitboard> attacks[2];
+};
+
+/*
+Count the legal moves and build both sides' attack maps for every position in a batch.
+Moves are counted set-wise rather than generated: pins and checks are found with occluded fills from the king,
+and each direction of movement contributes the population count of its reachable targets.
+*/
+void analyzeBatch(const PositionBatch &batch, BatchAnalysis &analysis);
+
+#endif // POSITION_BATCH_H
@@ -0,0 +1,203 @@
+#include "position_index.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "chessboard.h"
+#include "move.h"
+
+static const char indexMagic[8] = { 'C', 'H', 'E', 'S', 'S', 'I', 'D', 'X' };
+static const uint32_t indexVersion = 1;
+
+// One position reached in one game, with the move played from it (the null move after the last ply)
+struct Occurrence {
+    uint64_t key;
+    uint32_t game;
+    uint16_t move;
+
+    bool operator<(const Occurrence &other) const {
+        return (key != other.key) ? key < other.key : game < other.game;
+    }
+};
+
+/*
+Every occurrence is collected in memory and sorted by key, which groups the games and moves of each position together.
+Games come out in ascending order within a group, so a game that reaches a position more than once is listed once;
+its moves are then tallied, most frequent first.
+*/
+bool buildPositionIndex(const std::string &corpusPath, const std::string &indexPath) {
+    std::ifstream corpus(corpusPath);
+    if (!corpus) {
+        std::cerr << "Could not open corpus " << corpusPath << std::endl;
+        return false;
+    }
+
+    std::vector<Occurrence> occurrences;
+    std::string line, notation;
+    int lineNumber = 0;
+    uint32_t games = 0;
+    while (std::getline(corpus, line)) {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+
+        std::istringstream stream(line);
+        Chessboard chessboard;
+        while (stream >> notation) {
+            Move move = chessboard.parseMove(notation);
+            if (move.isNull()) {
+                std::cerr << corpusPath << ":" << lineNumber << ": illegal move " << notation << std::endl;
+                return false;
+            }
+            occurrences.push_back({ chessboard.key, games, move.getEncoding() });
+            chessboard.push(move);
+        }
+        occurrences.push_back({ chessboard.key, games, Move().getEncoding() });
+        games++;
+    }
+    std::sort(occurrences.begin(), occurrences.end());
+
+    std::vector<IndexEntry> entries;
+    std::vector<uint32_t> gameIds;
+    std::vector<IndexMoveStat> moves;
+    std::vector<uint16_t> played;
+    for (size_t first = 0, last; first < occurrences.size(); first = last) {
+        IndexEntry entry = { occurrences[first].key, static_cast<uint32_t>(gameIds.size()), 0,
+                             static_cast<uint32_t>(moves.size()), 0 };
+        played.clear();
+        for (last = first; last < occurrences.size() && occurrences[last].key == entry.key; last++) {
+            if (gameIds.size() == entry.firstGame || gameIds.back() != occurrences[last].game)
+                gameIds.push_back(occurrences[last].game);
+            if (occurrences[last].move)
+                played.push_back(occurrences[last].move);
+        }
+        entry.gameCount = static_cast<uint32_t>(gameIds.size() - entry.firstGame);
+
+        std::sort(played.begin(), played.end());
+        for (size_t i = 0, j; i < played.size(); i = j) {
+            for (j = i; j < played.size() && played[j] == played[i]; j++);
+            moves.push_back({ played[i], 0, static_cast<uint32_t>(j - i) });
+        }
+        std::stable_sort(moves.begin() + entry.firstMove, moves.end(), [](const IndexMoveStat &a, const IndexMoveStat &b) {
+            return a.count > b.count;
+        });
+        entry.moveCount = static_cast<uint32_t>(moves.size() - entry.firstMove);
+        entries.push_back(entry);
+    }
+
+    IndexHeader header = {};
+    std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.version = indexVersion;
+    header.entryCount = entries.size();
+    header.gameIdCount = gameIds.size();
+    header.moveCount = moves.size();
+    header.gameCount = games;
+
+    std::FILE *output = std::fopen(indexPath.c_str(), "wb");
+    if (!output) {
+        std::cerr << "Could not open index file " << indexPath << std::endl;
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, output) == 1 &&
+                   std::fwrite(entries.data(), sizeof(IndexEntry), entries.size(), output) == entries.size() &&
+                   std::fwrite(gameIds.data(), sizeof(uint32_t), gameIds.size(), output) == gameIds.size() &&
+                   std::fwrite(moves.data(), sizeof(IndexMoveStat), moves.size(), output) == moves.size();
+    written = (std::fclose(output) == 0) && written;
+    if (!written)
+        std::cerr << "Could not write index file " << indexPath << std::endl;
+    return written;
+}
+
+PositionIndex::~PositionIndex() {
+    close();
+}
+
+bool PositionIndex::open(const std::string &path) {
+    close();
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        std::cerr << "Could not open index file " << path << std::endl;
+        return false;
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(IndexHeader)) {
+        std::cerr << path << " is not a position index" << std::endl;
+        ::close(file);
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    mappingSize = status.st_size;
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Could not map index file " << path << std::endl;
+        mapping = nullptr;
+        return false;
+    }
+
+    // Check the header before trusting any of the counts in it
+    header = static_cast<const IndexHeader *>(mapping);
+    uint64_t expectedSize = sizeof(IndexHeader) + header->entryCount * sizeof(IndexEntry) +
+                            header->gameIdCount * sizeof(uint32_t) + header->moveCount * sizeof(IndexMoveStat);
+    if (std::memcmp(header->magic, indexMagic, sizeof(indexMagic)) != 0 || header->version != indexVersion ||
+        header->entryCount > mappingSize || header->gameIdCount > mappingSize || header->moveCount > mappingSize ||
+        expectedSize != mappingSize) {
+        std::cerr << path << " is not a position index" << std::endl;
+        close();
+        return false;
+    }
+
+    const char *data = static_cast<const char *>(mapping) + sizeof(IndexHeader);
+    entries = reinterpret_cast<const IndexEntry *>(data);
+    gameIds = reinterpret_cast<const uint32_t *>(data + header->entryCount * sizeof(IndexEntry));
+    moves = reinterpret_cast<const IndexMoveStat *>(gameIds + header->gameIdCount);
+    return true;
+}
+
+void PositionIndex::close() {
+    if (mapping)
+        munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    entries = nullptr;
+    gameIds = nullptr;
+    moves = nullptr;
+}
+
+/*
+Interpolation search guesses where the key lies from its value relative to the ends of the range,
+which takes about log log n probes on evenly spread keys instead of the log n of binary search.
+Every other probe bisects the range, so that an unlucky distribution can never do worse than twice binary search.
+*/
+const IndexEntry *PositionIndex::find(uint64_t key) const {
+    size_t low = 0, high = positionCount();
+    bool interpolate = true;
+    while (low < high) {
+        uint64_t lowKey = entries[low].key, highKey = entries[high - 1].key;
+        if (key < lowKey || key > highKey)
+            return nullptr;
+
+        size_t probe = low + (high - low) / 2;
+        if (interpolate && highKey != lowKey)
+            probe = low + static_cast<size_t>(static_cast<unsigned __int128>(key - lowKey) * (high - 1 - low) / (highKey - lowKey));
+        interpolate = !interpolate;
+
+        if (entries[probe].key < key)
+            low = probe + 1;
+        else if (entries[probe].key > key)
+            high = probe;
+        else
+            return &entries[probe];
+    }
+    return nullptr;
+}
@@ -0,0 +1,87 @@
+#ifndef POSITION_INDEX_H
+#define POSITION_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+On-disk index from positions to the games that reached them and the moves played from them.
+A corpus holds one game per line in coordinate notation, e.g. "e2e4 e7e5 g1f3", with games numbered from 0 in file order;
+blank lines and lines starting with '#' are skipped, as in openings files.
+
+The index file is laid out so that it can be mapped into memory and searched in place:
+    IndexHeader
+    IndexEntry[entryCount]     sorted by position key
+    uint32_t[gameIdCount]      game numbers of each entry, ascending
+    IndexMoveStat[moveCount]   moves played from each entry, most frequent first
+Zobrist keys are spread evenly over their range, so interpolation search finds an entry in a handful of probes.
+*/
+
+struct IndexHeader {
+    char magic[8]; // "CHESSIDX"
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t entryCount;
+    uint64_t gameIdCount;
+    uint64_t moveCount;
+    uint64_t gameCount; // Number of games in the corpus
+};
+
+// One distinct position, pointing at its slices of the game and move arrays
+struct IndexEntry {
+    uint64_t key;
+    uint32_t firstGame;
+    uint32_t gameCount;
+    uint32_t firstMove;
+    uint32_t moveCount;
+};
+
+// How many times a move was played from a position, the move being stored by its encoding
+struct IndexMoveStat {
+    uint16_t move;
+    uint16_t reserved;
+    uint32_t count;
+};
+
+static_assert(sizeof(IndexHeader) == 48 && sizeof(IndexEntry) == 24 && sizeof(IndexMoveStat) == 8, "The index layout is part of the file format");
+
+// Replay every game of a corpus and write the index, returning false if a file cannot be used or a game has an illegal move
+bool buildPositionIndex(const std::string &corpusPath, const std::string &indexPath);
+
+// Read-only view of an index file mapped into memory
+class PositionIndex {
+private:
+    void *mapping = nullptr;
+    size_t mappingSize = 0;
+    const IndexHeader *header = nullptr;
+    const IndexEntry *entries = nullptr;
+    const uint32_t *gameIds = nullptr;
+    const IndexMoveStat *moves = nullptr;
+
+public:
+    PositionIndex() = default;
+    PositionIndex(const PositionIndex &) = delete;
+    PositionIndex &operator=(const PositionIndex &) = delete;
+    ~PositionIndex();
+
+    // Map an index file, returning false if it cannot be read or is not a valid index
+    bool open(const std::string &path);
+    void close();
+
+    uint64_t positionCount() const { return header ? header->entryCount : 0; }
+    uint64_t gameCount() const { return header ? header->gameCount : 0; }
+
+    // Returns the entry of a position key, or nullptr if no game reached it
+    const IndexEntry *find(uint64_t key) const;
+    // Whether the slices of an entry lie within the arrays of the file, which a corrupt index may not ensure
+    bool inBounds(const IndexEntry &entry) const {
+        return static_cast<uint64_t>(entry.firstGame) + entry.gameCount <= header->gameIdCount &&
+               static_cast<uint64_t>(entry.firstMove) + entry.moveCount <= header->moveCount;
+    }
+    // Slices of the game numbers and move statistics belonging to an entry, which must be checked with inBounds first
+    const uint32_t *gamesOf(const IndexEntry &entry) const { return gameIds + entry.firstGame; }
+    const IndexMoveStat *movesOf(const IndexEntry &entry) const { return moves + entry.firstMove; }
+};
+
+#endif // POSITION_INDEX_H
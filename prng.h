@@ -0,0 +1,41 @@
+#ifndef PRNG_H
+#define PRNG_H
+
+#include <cstdint>
+
+/*
+A small, fast pseudo random number generator used in place of the global std::rand.
+Each game or worker owns its own generator, so results are reproducible from a seed and threads never share state.
+The generator is xorshift64*, seeded through splitmix64 so that nearby seeds still produce unrelated streams.
+More information about both algorithms can be found here:
+https://prng.di.unimi.it/
+*/
+class PRNG {
+private:
+    uint64_t state;
+
+public:
+    PRNG(uint64_t seed) {
+        // Scramble the seed with splitmix64, as xorshift must never be seeded with zero
+        seed += 0x9E3779B97F4A7C15ULL;
+        seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+        state = (seed ^ (seed >> 31)) | 1ULL;
+    }
+
+    // Returns the next 64 random bits
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    // Returns a random value in the range [0, bound)
+    uint64_t nextBelow(uint64_t bound) {
+        // Multiply-shift reduction avoids the division of a modulo
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(next()) * bound) >> 64);
+    }
+};
+
+#endif // PRNG_H
@@ -0,0 +1,87 @@
+#include "stats.h"
+
+#ifdef ENGINE_STATS
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+static const char *statNames[StatCounterCount] = {
+    "pawn_moves", "knight_moves", "bishop_moves", "rook_moves", "queen_moves", "king_moves",
+    "en_passant_rejections", "pushes", "pops", "cache_hits", "cache_misses", "cutoffs"
+};
+
+/*
+Registry of the counter blocks of running threads.
+When a thread exits, its counts are folded into the retired totals so they are not lost.
+*/
+struct StatRegistry {
+    std::mutex mutex;
+    std::vector<StatBlock *> blocks;
+    uint64_t retired[StatCounterCount] = {};
+
+    // Dump the totals once the program is finished
+    ~StatRegistry() {
+        const char *path = std::getenv("ENGINE_STATS_FILE");
+        std::FILE *file = path ? std::fopen(path, "w") : nullptr;
+        if (file) {
+            printStats(file, true);
+            std::fclose(file);
+        } else {
+            printStats(stderr, false);
+        }
+    }
+};
+
+// Function-local so that it is constructed before, and destroyed after, the first thread's counter block
+static StatRegistry &registry() {
+    static StatRegistry instance;
+    return instance;
+}
+
+thread_local StatBlock threadStats;
+
+StatBlock::StatBlock() {
+    for (int i = 0; i < StatCounterCount; i++)
+        counters[i].store(0, std::memory_order_relaxed);
+    StatRegistry &stats = registry();
+    std::lock_guard<std::mutex> lock(stats.mutex);
+    stats.blocks.push_back(this);
+}
+
+StatBlock::~StatBlock() {
+    StatRegistry &stats = registry();
+    std::lock_guard<std::mutex> lock(stats.mutex);
+    for (int i = 0; i < StatCounterCount; i++)
+        stats.retired[i] += counters[i].load(std::memory_order_relaxed);
+    stats.blocks.erase(std::find(stats.blocks.begin(), stats.blocks.end(), this));
+}
+
+void collectStats(uint64_t totals[StatCounterCount]) {
+    StatRegistry &stats = registry();
+    std::lock_guard<std::mutex> lock(stats.mutex);
+    for (int i = 0; i < StatCounterCount; i++) {
+        totals[i] = stats.retired[i];
+        for (StatBlock *block : stats.blocks)
+            totals[i] += block->counters[i].load(std::memory_order_relaxed);
+    }
+}
+
+void printStats(std::FILE *file, bool json) {
+    uint64_t totals[StatCounterCount];
+    collectStats(totals);
+
+    if (json) {
+        std::fprintf(file, "{");
+        for (int i = 0; i < StatCounterCount; i++)
+            std::fprintf(file, "%s\"%s\": %llu", i ? ", " : "", statNames[i], static_cast<unsigned long long>(totals[i]));
+        std::fprintf(file, "}\n");
+    } else {
+        std::fprintf(file, "%-22s %16s\n", "counter", "count");
+        for (int i = 0; i < StatCounterCount; i++)
+            std::fprintf(file, "%-22s %16llu\n", statNames[i], static_cast<unsigned long long>(totals[i]));
+    }
+}
+
+#endif // ENGINE_STATS
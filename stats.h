@@ -0,0 +1,66 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstdint>
+#include <cstdio>
+
+/*
+Hot-path statistics counters.
+Counting is only compiled in when ENGINE_STATS is defined (make STATS=1); otherwise every STATS_ macro expands to nothing.
+Each thread increments its own block of counters, so the hot path never contends on shared cache lines.
+Blocks are summed on demand, and the totals are dumped when the process exits:
+as a table on standard error, or as JSON to the file named by the ENGINE_STATS_FILE environment variable.
+*/
+enum StatCounter {
+    StatPawnMoves,
+    StatKnightMoves,
+    StatBishopMoves,
+    StatRookMoves,
+    StatQueenMoves,
+    StatKingMoves,
+    StatEnPassantRejections, // En passant captures that would expose the king; every other move is generated legal
+    StatPushes,
+    StatPops,
+    StatCacheHits,
+    StatCacheMisses,
+    StatCutoffs, // Mate solver nodes left unsolved once their proof or disproof number reached its threshold
+    StatCounterCount
+};
+
+#ifdef ENGINE_STATS
+
+#include <atomic>
+
+struct StatBlock {
+    /*
+    Counters are only ever written by their owning thread.
+    Relaxed loads and stores compile to plain memory operations, but keep reads from other threads well defined.
+    */
+    std::atomic<uint64_t> counters[StatCounterCount];
+
+    StatBlock();
+    ~StatBlock();
+
+    void add(StatCounter counter, uint64_t amount) {
+        counters[counter].store(counters[counter].load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+};
+
+extern thread_local StatBlock threadStats;
+
+// Sum the counters of every live and finished thread
+void collectStats(uint64_t totals[StatCounterCount]);
+// Write the current totals as an aligned table or as a JSON object
+void printStats(std::FILE *file, bool json);
+
+#define STATS_ADD(counter, amount) (threadStats.add((counter), (amount)))
+#define STATS_INC(counter) STATS_ADD(counter, 1)
+
+#else
+
+#define STATS_ADD(counter, amount) ((void)0)
+#define STATS_INC(counter) ((void)0)
+
+#endif // ENGINE_STATS
+
+#endif // STATS_H
@@ -0,0 +1,35 @@
+#include <cstdio>
+#include "../chessboard.h"
+#include "../mate_solver.h"
+
+/*
+Checks that the mate solver settles bare endgames without mate well within its node limit.
+The same position reached with different plies left once shared a table entry, and the searches at the two depths
+kept overwriting each other's numbers until the node limit ran out.
+Builds and runs with make test, exiting with a failure status if any check fails.
+*/
+
+static int failures = 0;
+
+static void checkNoMate(const char *name, const std::string &fen, int maxMoves) {
+    Chessboard board;
+    MateSearchLimits limits;
+    limits.maxMoves = maxMoves;
+    limits.maxNodes = 1000000;
+    MateSolver solver(16);
+    MateSolution solution;
+    bool loaded = board.loadFEN(fen);
+    if (loaded)
+        solution = solver.solve(board, limits);
+    bool passed = loaded && solution.result == MateResult::NoMate;
+    std::printf("%s %s: no mate in %d, %llu nodes\n", passed ? "ok  " : "FAIL", name, maxMoves, static_cast<unsigned long long>(solution.nodes));
+    if (!passed)
+        failures++;
+}
+
+int main() {
+    checkNoMate("KvK", "8/8/8/8/8/8/k7/2K5 w - - 0 1", 3);
+    checkNoMate("KQvK", "8/8/8/4k3/8/8/3QK3/8 w - - 0 1", 3);
+    checkNoMate("KRvK", "4k3/8/8/8/8/8/8/R3K3 w - - 0 1", 3);
+    return failures ? 1 : 0;
+}
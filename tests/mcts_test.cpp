@@ -0,0 +1,59 @@
+#include <cstdio>
+#include "../chessboard.h"
+#include "../mcts.h"
+
+/*
+Checks that a search started from a finished game searches nothing and reports how the game ended,
+including draws by rule where legal moves remain.
+Builds and runs with make test, exiting with a failure status if any check fails.
+*/
+
+static int failures = 0;
+
+static void checkRootStatus(const char *name, const std::string &fen, const std::vector<std::string> &moves, GameStatus expected) {
+    Chessboard board;
+    if (!board.loadFEN(fen)) {
+        std::printf("FAIL %s: invalid FEN\n", name);
+        failures++;
+        return;
+    }
+    for (size_t i = 0; i < moves.size(); i++) {
+        Move move = board.parseMove(moves[i]);
+        if (move.isNull()) {
+            std::printf("FAIL %s: illegal move %s\n", name, moves[i].c_str());
+            failures++;
+            return;
+        }
+        board.push(move);
+    }
+
+    MctsSearch search(1);
+    MctsLimits limits;
+    limits.maxPlayouts = 100;
+    MctsResult result = search.search(board, limits);
+    bool passed = result.status == expected && result.bestMove.isNull() && result.playouts == 0;
+    std::printf("%s %s\n", passed ? "ok  " : "FAIL", name);
+    if (!passed)
+        failures++;
+}
+
+int main() {
+    checkRootStatus("checkmate", "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3", {}, GameStatus::Checkmate);
+    checkRootStatus("stalemate", "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", {}, GameStatus::Stalemate);
+    checkRootStatus("insufficient material", "8/8/4k3/8/8/3K4/8/8 w - - 0 1", {}, GameStatus::InsufficientMaterial);
+    checkRootStatus("fifty-move rule", "8/8/4k3/8/8/3K4/8/R7 w - - 100 80", {}, GameStatus::FiftyMoveRule);
+    checkRootStatus("repetition", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                    { "g1f3", "g8f6", "f3g1", "f6g8", "g1f3", "g8f6", "f3g1", "f6g8" }, GameStatus::Repetition);
+
+    // A game still in progress is searched as usual
+    Chessboard board;
+    MctsSearch search(1);
+    MctsLimits limits;
+    limits.maxPlayouts = 100;
+    MctsResult result = search.search(board, limits);
+    bool passed = result.status == GameStatus::Ongoing && !result.bestMove.isNull() && result.playouts == 100;
+    std::printf("%s ongoing\n", passed ? "ok  " : "FAIL");
+    if (!passed)
+        failures++;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+#include "trace.h"
+
+#ifdef ENGINE_TRACE
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+// Events of one thread, copied out of its ring buffer in recording order
+struct ThreadEvents {
+    int thread;
+    std::vector<TraceEvent> events;
+};
+
+// Copy the events still held by a ring buffer, oldest first
+static ThreadEvents snapshot(const TraceBuffer &buffer) {
+    ThreadEvents result = { buffer.thread, {} };
+    uint64_t recorded = buffer.recorded.load(std::memory_order_acquire);
+    uint64_t first = (recorded > TraceBuffer::capacity) ? recorded - TraceBuffer::capacity : 0;
+    for (uint64_t index = first; index < recorded; index++)
+        result.events.push_back(buffer.events[index & (TraceBuffer::capacity - 1)]);
+    return result;
+}
+
+/*
+Registry of the ring buffers of running threads.
+When a thread exits, its events are copied into the retired list so they are not lost.
+The time stamp counter and the steady clock are both read when tracing starts and again on export,
+which gives the rate for converting ticks into microseconds without depending on a fixed counter frequency.
+*/
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<TraceBuffer *> buffers;
+    std::vector<ThreadEvents> retired;
+    int nextThread = 0;
+    uint64_t startTicks = traceTimestamp();
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    // Export the events once the program is finished
+    ~TraceRegistry() {
+        const char *path = std::getenv("ENGINE_TRACE_FILE");
+        if (!writeTrace(path ? path : "trace.json"))
+            std::fprintf(stderr, "Could not write trace to %s\n", path ? path : "trace.json");
+    }
+};
+
+// Function-local so that it is constructed before, and destroyed after, the first thread's ring buffer
+static TraceRegistry &registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+thread_local TraceBuffer threadTrace;
+
+TraceBuffer::TraceBuffer() : events(new TraceEvent[capacity]), recorded(0) {
+    TraceRegistry &traces = registry();
+    std::lock_guard<std::mutex> lock(traces.mutex);
+    thread = traces.nextThread++;
+    traces.buffers.push_back(this);
+}
+
+TraceBuffer::~TraceBuffer() {
+    TraceRegistry &traces = registry();
+    {
+        std::lock_guard<std::mutex> lock(traces.mutex);
+        traces.retired.push_back(snapshot(*this));
+        traces.buffers.erase(std::find(traces.buffers.begin(), traces.buffers.end(), this));
+    }
+    delete[] events;
+}
+
+bool writeTrace(const char *path) {
+    TraceRegistry &traces = registry();
+    std::vector<ThreadEvents> threads;
+    {
+        std::lock_guard<std::mutex> lock(traces.mutex);
+        threads = traces.retired;
+        for (TraceBuffer *buffer : traces.buffers)
+            threads.push_back(snapshot(*buffer));
+    }
+
+    double elapsedMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - traces.startTime).count();
+    double ticksPerMicrosecond = (traceTimestamp() - traces.startTicks) / std::max(elapsedMicroseconds, 1.0);
+
+    std::FILE *file = std::fopen(path, "w");
+    if (!file)
+        return false;
+
+    // Complete events ("X") nest by time within a thread, which is what produces the flame chart
+    std::fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    bool first = true;
+    for (const ThreadEvents &thread : threads) {
+        std::fprintf(file, "%s  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+                     first ? "" : ",\n", thread.thread, thread.thread);
+        first = false;
+        for (const TraceEvent &event : thread.events) {
+            double start = (static_cast<double>(event.start) - static_cast<double>(traces.startTicks)) / ticksPerMicrosecond;
+            double duration = static_cast<double>(event.end - event.start) / ticksPerMicrosecond;
+            std::fprintf(file, ",\n  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                         event.name, thread.thread, start, duration);
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+    return true;
+}
+
+#endif // ENGINE_TRACE
@@ -0,0 +1,76 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+
+/*
+Scoped trace profiler for looking inside the hot path.
+Tracing is only compiled in when ENGINE_TRACE is defined (make TRACE=1); otherwise TRACE_SCOPE expands to nothing.
+A TRACE_SCOPE records the time from its declaration to the end of the enclosing block as one event.
+Each thread appends events to its own fixed-size ring buffer, overwriting the oldest once it is full, so recording never locks or allocates.
+When the process exits, the events are written in Chrome trace format to the file named by the ENGINE_TRACE_FILE environment variable,
+or trace.json by default, which chrome://tracing and https://ui.perfetto.dev show as a flame chart per thread.
+*/
+
+#ifdef ENGINE_TRACE
+
+#include <atomic>
+#include <chrono>
+
+// Read the time stamp counter where there is one, which costs far less than a clock call; ticks are converted to time on export
+inline uint64_t traceTimestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+struct TraceEvent {
+    const char *name; // Must outlive the process, such as a string literal
+    uint64_t start;
+    uint64_t end;
+};
+
+struct TraceBuffer {
+    static const uint64_t capacity = 1 << 16;
+
+    TraceEvent *events;
+    // Number of events ever recorded; only the owning thread writes it, and the release store publishes each event
+    std::atomic<uint64_t> recorded;
+    int thread;
+
+    TraceBuffer();
+    ~TraceBuffer();
+
+    void record(const char *name, uint64_t start, uint64_t end) {
+        uint64_t index = recorded.load(std::memory_order_relaxed);
+        events[index & (capacity - 1)] = { name, start, end };
+        recorded.store(index + 1, std::memory_order_release);
+    }
+};
+
+extern thread_local TraceBuffer threadTrace;
+
+struct TraceScope {
+    const char *name;
+    uint64_t start;
+
+    explicit TraceScope(const char *name) : name(name), start(traceTimestamp()) {}
+    ~TraceScope() { threadTrace.record(name, start, traceTimestamp()); }
+};
+
+// Write the events of every thread in Chrome trace format, returning false if the file cannot be written
+bool writeTrace(const char *path);
+
+#define TRACE_CONCATENATE_INNER(first, second) first##second
+#define TRACE_CONCATENATE(first, second) TRACE_CONCATENATE_INNER(first, second)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCATENATE(traceScope, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+
+#endif // ENGINE_TRACE
+
+#endif // TRACE_H
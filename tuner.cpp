@@ -0,0 +1,233 @@
+#include "tuner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "evaluation.h"
+#include "memory.h"
+#include "position.h"
+
+// A piece as a tuning feature: its color above its piece type above the square it stands on as seen by white
+typedef uint16_t TuneFeature;
+
+// A labeled position, whose pieces are features firstFeature onwards
+struct TunePosition {
+    uint32_t firstFeature;
+    uint8_t featureCount;
+    uint8_t phase;
+    uint8_t result; // Half points for white
+};
+
+struct TuneData {
+    std::vector<TunePosition> positions;
+    std::vector<TuneFeature> features;
+};
+
+// Results read as half points for white, or -1 when the token is not a result
+static int parseResult(std::string token) {
+    token.erase(std::remove_if(token.begin(), token.end(), [](char c) { return c == '"' || c == '[' || c == ']' || c == ';'; }), token.end());
+    if (token == "1-0" || token == "1.0")
+        return 2;
+    if (token == "1/2-1/2" || token == "0.5")
+        return 1;
+    if (token == "0-1" || token == "0.0")
+        return 0;
+    return -1;
+}
+
+static bool loadTuneData(const std::string &path, TuneData &data) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Could not open tuning data " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    Position position;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+
+        /*
+        The FEN takes the first six words, clocks included, and the result is a separate last word after them.
+        A line cut short is rejected rather than having a FEN field, such as the move number, read as its result.
+        */
+        std::istringstream stream(line);
+        std::vector<std::string> words;
+        for (std::string word; stream >> word;)
+            words.push_back(word);
+        int result = (words.size() > 6) ? parseResult(words.back()) : -1;
+        std::string fen;
+        for (size_t i = 0; i < 6 && i < words.size(); i++)
+            fen += (i ? " " : "") + words[i];
+        if (result < 0 || !position.loadFEN(fen)) {
+            std::cerr << path << ":" << lineNumber << ": expected a FEN of six fields followed by a result" << std::endl;
+            return false;
+        }
+
+        TunePosition entry = { static_cast<uint32_t>(data.features.size()), 0, static_cast<uint8_t>(gamePhase(position)), static_cast<uint8_t>(result) };
+        for (int color = White; color <= Black; color++) {
+            int mirror = (color == White) ? 0 : 56;
+            for (int type = Pawn; type <= King; type++)
+                for (Bitboard pieces = position.pieces[color][type]; pieces;)
+                    data.features.push_back(static_cast<TuneFeature>((color << 9) | (type << 6) | (POP_LSB(pieces) ^ mirror)));
+        }
+        entry.featureCount = static_cast<uint8_t>(data.features.size() - entry.firstFeature);
+        data.positions.push_back(entry);
+    }
+
+    if (data.positions.empty()) {
+        std::cerr << "No positions found in " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Midgame and endgame evaluation for white with real-valued weights, before blending by phase
+static void evaluateFeatures(const TuneData &data, const TunePosition &position, const double *weights, double scores[2]) {
+    scores[Midgame] = scores[Endgame] = 0;
+    for (uint32_t i = position.firstFeature; i < position.firstFeature + position.featureCount; i++) {
+        TuneFeature feature = data.features[i];
+        int type = (feature >> 6) & 7, square = feature & 63;
+        double sign = (feature >> 9) ? -1 : 1;
+        for (int phase = Midgame; phase <= Endgame; phase++)
+            scores[phase] += sign * (weights[EvalParams::materialIndex(phase, type)] + weights[EvalParams::pieceSquareIndex(phase, type, square)]);
+    }
+}
+
+/*
+One pass over the data, split into a contiguous share per thread, returning the mean squared error.
+With gradient given, the gradient of the error with respect to every weight is added into it as well.
+Each thread adds up its share of the gradient in its own arena, which lasts the whole run instead of being allocated every pass.
+*/
+static double tunePass(const TuneData &data, const std::vector<double> &weights, double scaling, std::vector<ThreadArena> &arenas, std::vector<double> *gradient) {
+    // The expected score is 1 / (1 + 10^(-scaling * eval / 400)), written with exp
+    const double slope = scaling * std::log(10.0) / 400;
+    size_t count = data.positions.size();
+    int threadCount = static_cast<int>(arenas.size());
+    std::vector<double> errors(threadCount, 0.0);
+    std::vector<double *> gradients(threadCount, nullptr);
+
+    auto worker = [&](int thread) {
+        double *threadGradient = nullptr;
+        if (gradient) {
+            arenas[thread].reset();
+            threadGradient = gradients[thread] = arenas[thread].allocate<double>(EvalParams::COUNT);
+            std::fill(threadGradient, threadGradient + EvalParams::COUNT, 0.0);
+        }
+        double error = 0;
+        for (size_t i = count * thread / threadCount; i < count * (thread + 1) / threadCount; i++) {
+            const TunePosition &position = data.positions[i];
+            double scores[2];
+            evaluateFeatures(data, position, weights.data(), scores);
+            double midgameShare = position.phase / static_cast<double>(MAX_PHASE);
+            double eval = scores[Midgame] * midgameShare + scores[Endgame] * (1 - midgameShare);
+            double expected = 1 / (1 + std::exp(-slope * eval));
+            double difference = position.result / 2.0 - expected;
+            error += difference * difference;
+            if (!threadGradient)
+                continue;
+
+            // Every weight enters the evaluation with a coefficient of plus or minus its phase share
+            double factor = -2 * difference * expected * (1 - expected) * slope;
+            double shares[2] = { factor * midgameShare, factor * (1 - midgameShare) };
+            for (uint32_t j = position.firstFeature; j < position.firstFeature + position.featureCount; j++) {
+                TuneFeature feature = data.features[j];
+                int type = (feature >> 6) & 7, square = feature & 63;
+                double sign = (feature >> 9) ? -1 : 1;
+                for (int phase = Midgame; phase <= Endgame; phase++) {
+                    threadGradient[EvalParams::materialIndex(phase, type)] += sign * shares[phase];
+                    threadGradient[EvalParams::pieceSquareIndex(phase, type, square)] += sign * shares[phase];
+                }
+            }
+        }
+        errors[thread] = error;
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++)
+        threads.emplace_back(worker, i);
+    worker(0);
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    double error = 0;
+    for (int i = 0; i < threadCount; i++) {
+        error += errors[i];
+        if (gradient)
+            for (int j = 0; j < EvalParams::COUNT; j++)
+                (*gradient)[j] += gradients[i][j] / count;
+    }
+    return error / count;
+}
+
+// The scaling that best fits the starting weights to the results, by golden section search
+static double fitScaling(const TuneData &data, const std::vector<double> &weights, std::vector<ThreadArena> &arenas) {
+    const double ratio = (std::sqrt(5.0) - 1) / 2;
+    double low = 0.1, high = 5.0;
+    double a = high - ratio * (high - low), b = low + ratio * (high - low);
+    double errorA = tunePass(data, weights, a, arenas, nullptr), errorB = tunePass(data, weights, b, arenas, nullptr);
+    for (int i = 0; i < 30; i++) {
+        if (errorA < errorB) {
+            high = b, b = a, errorB = errorA;
+            a = high - ratio * (high - low);
+            errorA = tunePass(data, weights, a, arenas, nullptr);
+        } else {
+            low = a, a = b, errorA = errorB;
+            b = low + ratio * (high - low);
+            errorB = tunePass(data, weights, b, arenas, nullptr);
+        }
+    }
+    return (low + high) / 2;
+}
+
+bool runTuner(const TuneConfig &config) {
+    EvalParams params = defaultEvalParams();
+    if (!config.paramsFile.empty() && !loadEvalParams(config.paramsFile, params))
+        return false;
+
+    auto start = std::chrono::steady_clock::now();
+    TuneData data;
+    if (!loadTuneData(config.dataFile, data))
+        return false;
+    std::vector<ThreadArena> arenas;
+    for (int i = 0; i < std::max(1, config.threads); i++)
+        arenas.emplace_back(EvalParams::COUNT * sizeof(double));
+    std::fprintf(stderr, "Positions: %zu  Loaded in %.2fs\n", data.positions.size(),
+                 std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    std::vector<double> weights(params.values(), params.values() + EvalParams::COUNT);
+    double scaling = (config.scaling > 0) ? config.scaling : fitScaling(data, weights, arenas);
+    std::fprintf(stderr, "Scaling: %.4f  Error: %.6f\n", scaling, tunePass(data, weights, scaling, arenas, nullptr));
+
+    // Adam keeps running averages of the gradient and of its square for every weight
+    const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    std::vector<double> gradient(EvalParams::COUNT), momentum(EvalParams::COUNT, 0.0), velocity(EvalParams::COUNT, 0.0);
+    start = std::chrono::steady_clock::now();
+    for (int epoch = 1; epoch <= config.epochs; epoch++) {
+        std::fill(gradient.begin(), gradient.end(), 0.0);
+        double error = tunePass(data, weights, scaling, arenas, &gradient);
+        double correction1 = 1 - std::pow(beta1, epoch), correction2 = 1 - std::pow(beta2, epoch);
+        for (int i = 0; i < EvalParams::COUNT; i++) {
+            momentum[i] = beta1 * momentum[i] + (1 - beta1) * gradient[i];
+            velocity[i] = beta2 * velocity[i] + (1 - beta2) * gradient[i] * gradient[i];
+            weights[i] -= config.learningRate * (momentum[i] / correction1) / (std::sqrt(velocity[i] / correction2) + epsilon);
+        }
+        if (epoch % config.reportInterval == 0 || epoch == config.epochs) {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::fprintf(stderr, "Epoch: %d  Error: %.6f  Time: %.2fs  Epochs per second: %.1f\n", epoch, error, seconds, epoch / std::max(seconds, 1e-9));
+        }
+    }
+
+    for (int i = 0; i < EvalParams::COUNT; i++)
+        params.values()[i] = static_cast<int>(std::lround(weights[i]));
+    return saveEvalParams(config.outputFile, params);
+}
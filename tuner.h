@@ -0,0 +1,31 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <string>
+
+/*
+Texel-style tuning of the evaluation weights against positions labeled with the results of their games.
+The evaluation is turned into an expected score with a sigmoid, and the mean squared difference between
+expected and actual results is minimized by gradient descent with Adam, which keeps a separate step size for every weight.
+The evaluation is linear in its weights, so each position is stored once as the list of its pieces,
+and every epoch is a pass over those lists split across worker threads, each adding up its own share of the gradient.
+More information can be found here:
+https://www.chessprogramming.org/Texel%27s_Tuning_Method
+*/
+
+// Settings for a tuning run
+struct TuneConfig {
+    std::string dataFile; // One position per line: a full six-field FEN followed by the result, "1-0", "1/2-1/2", "0-1" or 1.0, 0.5, 0.0
+    std::string paramsFile; // Weights to start from; the defaults when empty
+    std::string outputFile; // Tuned weights are written to standard output when empty
+    int epochs = 1000;
+    int threads = 1;
+    double learningRate = 1.0; // In centipawns per step
+    double scaling = 0; // Scaling of the sigmoid; fitted to the starting weights when zero
+    int reportInterval = 100; // Epochs between progress reports
+};
+
+// Load the data, tune and write the weights out, returning false if any file cannot be read or written
+bool runTuner(const TuneConfig &config);
+
+#endif // TUNER_H
@@ -16,6 +16,9 @@ enum Color {
     Black
 };
 
+// Returns the opposing color
+constexpr Color operator~(Color color) { return static_cast<Color>(color ^ 1); }
+
 /*
 Assignment follows a right-to-left, bottom-to-top pattern in reference to the corresponding positions on a chessboard.
 Since H1 = 0, the LSB corresponds to the bottom right of the board.
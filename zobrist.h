@@ -0,0 +1,45 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+#include "types.h"
+
+/*
+Zobrist hashing assigns a random 64-bit key to every piece on every square and to every other piece of position state.
+The key of a position is the XOR of the keys of everything present, so a move updates it with a handful of XORs.
+The keys are generated at compile time with splitmix64, which keeps them identical across runs and builds.
+More information can be found here:
+https://www.chessprogramming.org/Zobrist_Hashing
+*/
+struct ZobristKeys {
+    uint64_t pieces[2][6][64];
+    uint64_t castling[4]; // White king side, white queen side, black king side, black queen side
+    uint64_t enPassant[8]; // Indexed by the file of the pawn that can be captured
+    uint64_t side; // Present when black is to move
+};
+
+constexpr ZobristKeys makeZobristKeys() {
+    ZobristKeys keys = {};
+    uint64_t state = 0x5A0B8157C3D2E1F0ULL;
+    auto next = [&state]() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    };
+
+    for (int color = White; color <= Black; color++)
+        for (int type = Pawn; type <= King; type++)
+            for (int square = 0; square < 64; square++)
+                keys.pieces[color][type][square] = next();
+    for (int i = 0; i < 4; i++)
+        keys.castling[i] = next();
+    for (int i = 0; i < 8; i++)
+        keys.enPassant[i] = next();
+    keys.side = next();
+    return keys;
+}
+
+inline constexpr ZobristKeys zobrist = makeZobristKeys();
+
+#endif // ZOBRIST_H